@@ -0,0 +1,104 @@
+#include "batch_analysis.h"
+#include "bot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct Result {
+        std::string line;
+        uint64_t nodes = 0;
+        bool error = false;
+        bool done = false;
+    };
+
+}
+
+BatchSummary analyzeBatch(std::istream& input, std::ostream& output, const BatchOptions& options) {
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line[0] != '#') lines.push_back(std::move(line));
+    }
+
+    int jobs = options.jobs > 0 ? options.jobs : (int)std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::max(1, std::min<int>(jobs, (int)lines.size()));
+
+    std::vector<Result> results(lines.size());
+    std::atomic<size_t> nextJob{0};
+    std::mutex outputMutex;
+    size_t nextToWrite = 0;
+
+    // A depth- or node-limited result only depends on the position if nothing
+    // carries over from the previous one. Under a time limit results vary
+    // anyway, so the table is kept.
+    bool resetEachPosition = options.limits.moveTime == 0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&] {
+        Bot bot;
+        bot.setHashSize(options.hashMB);
+        SearchInfo info;
+        bot.setProgressCallback([&info](const SearchInfo& progress) {
+            if (progress.multiPV == 1) info = progress;
+        });
+
+        for (size_t index = nextJob++; index < lines.size(); index = nextJob++) {
+            Result& result = results[index];
+            std::string fen;
+            if (!Board::extractEPDPosition(lines[index], fen)) {
+                result.line = lines[index] + " error invalid EPD";
+                result.error = true;
+            } else {
+                try {
+                    Board board;
+                    board.loadFEN(fen + " 0 1");
+                    if (resetEachPosition) bot.newGame();
+                    info = SearchInfo();
+                    Move best = bot.findBestMove(board, options.limits);
+
+                    std::ostringstream out;
+                    out << fen << " bestmove " << best.toString() << " score ";
+                    if (info.mateIn != 0) out << "mate " << info.mateIn;
+                    else out << "cp " << info.score;
+                    out << " depth " << info.depth << " nodes " << bot.getNodesSearched()
+                        << " time " << bot.getSearchStats().timeMs;
+                    result.line = out.str();
+                    result.nodes = bot.getNodesSearched();
+                } catch (const std::exception& e) {
+                    result.line = fen + " error " + e.what();
+                    result.error = true;
+                }
+            }
+
+            // Write out the finished prefix of the input
+            std::lock_guard<std::mutex> lock(outputMutex);
+            result.done = true;
+            while (nextToWrite < results.size() && results[nextToWrite].done) {
+                output << results[nextToWrite].line << '\n';
+                nextToWrite++;
+            }
+            output.flush();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int j = 0; j < jobs; j++) workers.emplace_back(worker);
+    for (auto& thread : workers) thread.join();
+
+    BatchSummary summary;
+    summary.positions = results.size();
+    for (const auto& result : results) {
+        summary.nodes += result.nodes;
+        if (result.error) summary.errors++;
+    }
+    summary.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "time_manager.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+struct BatchOptions {
+    SearchLimits limits;
+    int jobs = 0;               // 0 = one per hardware thread
+    size_t hashMB = 16;         // per job
+};
+
+struct BatchSummary {
+    size_t positions = 0;
+    size_t errors = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+};
+
+// Analyses every EPD (or FEN) line of input with independent single-threaded
+// searches. Each job has its own Bot and transposition table and takes the
+// next position from a shared queue, so throughput scales with the number
+// of jobs. For depth- or node-limited searches the bot is reset before
+// every position, which makes the results independent of scheduling.
+//
+// One line per position is written to output, in input order, as soon as
+// it and all positions before it are done:
+//   <fen> bestmove <move> score cp <n>|mate <n> depth <n> nodes <n> time <ms>
+// or "<fen> error <message>" for positions that cannot be searched.
+BatchSummary analyzeBatch(std::istream& input, std::ostream& output, const BatchOptions& options);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+struct BenchResult {
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    uint64_t nps = 0;
+    // Hash of every position's node count and best move. Any change to what
+    // the search does changes it; a pure speedup does not.
+    uint64_t signature = 0;
+};
+
+// Searches a fixed set of positions to depth, each from a fresh state (see
+// Bot::newGame), and prints one line per position plus the totals to
+// out. The node counts and signature are reproducible with a single thread;
+// helper threads make them vary from run to run.
+//
+// With json given, the totals and every position's SearchStats are also
+// written there as one JSON object, for tracking search regressions.
+BenchResult runBench(int depth, int threads, size_t hashMB, std::ostream& out, std::ostream* json = nullptr);
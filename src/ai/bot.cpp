@@ -1,178 +1,933 @@
 #include "bot.h"
 #include "../core/move_generator.h"
 #include "evaluate.h"
-#include <limits>
+#include "see.h"
 #include <algorithm>
+#include <cstring>
+#include <cstdlib>
 #include <stdexcept>
 #include <iostream>
 
+Bot::Bot() : transpositionTable(DEFAULT_HASH_MB) {
+    threads.push_back(std::make_unique<SearchThread>(0));
+}
+
+Bot::~Bot() {
+    cancelBackgroundSearch();
+    stopHelpers();
+}
+
+void Bot::setThreads(int count) {
+    count = std::max(1, count);
+    stopHelpers();
+    threads.resize(1);
+
+    for (int i = 1; i < count; i++) {
+        threads.push_back(std::make_unique<SearchThread>(i));
+        SearchThread* helper = threads.back().get();
+        helper->lastSearchId = searchId;
+        helper->thread = std::thread(&Bot::helperLoop, this, helper);
+    }
+}
+
+void Bot::setHashSize(size_t megabytes, bool hugePages) {
+    transpositionTable.resize(megabytes, hugePages);
+}
+
+void Bot::newGame() {
+    cancelBackgroundSearch();
+    transpositionTable.clear();
+    for (auto& thread : threads) {
+        std::memset(thread->history, 0, sizeof(thread->history));
+    }
+}
+
+void Bot::stopHelpers() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        quitHelpers = true;
+    }
+    poolCondition.notify_all();
+
+    for (size_t i = 1; i < threads.size(); i++) {
+        threads[i]->thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    quitHelpers = false;
+}
+
+void Bot::helperLoop(SearchThread* helper) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolCondition.wait(lock, [&] { return quitHelpers || searchId != helper->lastSearchId; });
+            if (quitHelpers) return;
+            helper->lastSearchId = searchId;
+        }
+
+        // Only the main thread's result is used, so its errors are the
+        // ones reported; a helper that fails simply stops early.
+        try {
+            iterativeDeepening(*helper, *helper->rootBoard, helper->maxDepth);
+        } catch (...) {
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            activeHelpers--;
+        }
+        poolCondition.notify_all();
+    }
+}
+
 Move Bot::findBestMove(Board &board, int depth) {
-    nodesSearched = 0;
-    ttHits = 0;
-    
-    // Clear or initialize transposition table occasionally
-    static int callCount = 0;
-    if (++callCount % 10 == 0) {
-        for (int i = 0; i < TT_SIZE; i++) {
-            transpositionTable[i].isValid = false;
+    return findBestMove(board, SearchLimits::fixedDepth(depth));
+}
+
+Move Bot::findBestMove(Board &board, const SearchLimits& searchLimits, SearchStats* stats) {
+    cancelBackgroundSearch();
+    Move bestMove;
+    if (findInstantMove(board, searchLimits, bestMove)) {
+        if (stats)
+            *stats = searchStats;
+        return bestMove;
+    }
+
+    requireLegalMoves(board);
+    prepareSearch(board, searchLimits);
+    bestMove = runSearch(board);
+    if (stats)
+        *stats = searchStats;
+    return bestMove;
+}
+
+void Bot::start(const Board& board, const SearchLimits& searchLimits) {
+    cancelBackgroundSearch();
+
+    backgroundError = nullptr;
+    if (findInstantMove(board, searchLimits, backgroundResult)) {
+        backgroundThread = std::thread([] {});
+        return;
+    }
+
+    // Reported by wait(), like any other search error
+    try {
+        requireLegalMoves(board);
+    } catch (...) {
+        backgroundError = std::current_exception();
+        backgroundThread = std::thread([] {});
+        return;
+    }
+
+    backgroundBoard = std::make_unique<Board>(board);
+    prepareSearch(*backgroundBoard, searchLimits);
+    backgroundThread = std::thread([this] {
+        try {
+            backgroundResult = runSearch(*backgroundBoard);
+        } catch (...) {
+            backgroundError = std::current_exception();
         }
+    });
+}
+
+Move Bot::wait() {
+    if (!backgroundThread.joinable())
+        throw std::runtime_error("No search to wait for");
+
+    backgroundThread.join();
+    backgroundBoard.reset();
+    if (backgroundError)
+        std::rethrow_exception(backgroundError);
+    return backgroundResult;
+}
+
+void Bot::cancelBackgroundSearch() {
+    if (!backgroundThread.joinable())
+        return;
+
+    stopSearch = true;
+    backgroundThread.join();
+    backgroundBoard.reset();
+    pondering = false;
+}
+
+bool Bot::startPondering(const Board& board, const Move& expectedReply, const SearchLimits& searchLimits) {
+    cancelBackgroundSearch();
+    if (!hasMove(expectedReply))
+        return false;
+
+    Board position = board;
+    if (!position.movePiece(expectedReply.fromRow, expectedReply.fromCol, expectedReply.toRow, expectedReply.toCol))
+        return false;
+
+    // Nothing to search after a reply that ends the game
+    MoveGenerator moveGenerator;
+    if (moveGenerator.generateLegalMoves(position, position.getCurrentTurn()).empty())
+        return false;
+
+    SearchLimits ponderLimits = searchLimits;
+    ponderLimits.ponder = true;
+    start(position, ponderLimits);
+    ponderMove = expectedReply;
+    return true;
+}
+
+void Bot::ponderHit() {
+    if (!pondering)
+        return;
+
+    // The clock starts now. The time manager is only read once pondering
+    // is cleared, so it can be restarted from this thread.
+    limits.ponder = false;
+    timeManager.start(limits, searchSide);
+    pondering = false;
+}
+
+void Bot::stopPondering() {
+    // The TT keeps whatever the ponder search found
+    if (isPondering())
+        cancelBackgroundSearch();
+}
+
+Move Bot::getPonderMove(const Board& board) {
+    if (threads[0]->rootMoves.empty())
+        return Move();
+    const RootMove& best = threads[0]->rootMoves[0];
+    if (best.pv.size() >= 2)
+        return best.pv[1];
+
+    // The PV can be cut short by a TT hit; fall back to the table's move for
+    // the position after our move, if it is legal there.
+    Board temp = board;
+    if (!temp.movePiece(best.move.fromRow, best.move.fromCol, best.move.toRow, best.move.toCol))
+        return Move();
+
+    int ttScore;
+    Move ttMove;
+    probeTT(temp.getHash(), MAX_PLY, -INF, INF, 0, ttScore, ttMove);
+    MoveGenerator moveGenerator;
+    for (const auto& move : moveGenerator.generateLegalMoves(temp, temp.getCurrentTurn())) {
+        if (hasMove(ttMove) && move.sameSquares(ttMove))
+            return move;
     }
-    
-    Move bestMove = iterativeDeepening(board, depth);
-    
-    std::cout << "Nodes searched: " << nodesSearched << ", TT hits: " << ttHits << std::endl;
+    return Move();
+}
+
+// Book and endgame table moves need no search. On a hit, the last search's
+// results are cleared so that nothing (statistics, node count, ponder move)
+// describes a search that did not happen; a table move is reported as the
+// only line, with the table's score.
+bool Bot::findInstantMove(const Board& board, const SearchLimits& searchLimits, Move& move) {
+    if (searchLimits.infinite || searchLimits.ponder)
+        return false;
+    int score = 0;
+    if (book && book->pickMove(board, bookRandom, move))
+        moveSource = MoveSource::BOOK;
+    else if (useEndgameTables && bestTableMove(board, move, score))
+        moveSource = MoveSource::ENDGAME_TABLES;
+    else if (bestSyzygyMove(board, move, score))
+        moveSource = MoveSource::ENDGAME_TABLES;
+    else
+        return false;
+
+    for (auto& thread : threads) {
+        thread->nodesSearched = 0;
+        thread->rootMoves.clear();
+    }
+    searchStats = SearchStats();
+    pvLines.clear();
+
+    if (moveSource == MoveSource::ENDGAME_TABLES) {
+        SearchInfo info;
+        info.score = score;
+        info.mateIn = mateIn(score);
+        info.pv.push_back(move);
+        pvLines.push_back(info);
+        reportProgress();
+    }
+    return true;
+}
+
+// The fastest win, the slowest loss, or any move that keeps the draw.
+bool Bot::bestTableMove(const Board& board, Move& move, int& score) {
+    EndgameTables::Result result;
+    if (!EndgameTables::probe(board, result))
+        return false;
+
+    MoveGenerator moveGenerator;
+    int bestScore = -INF;
+    for (const auto& candidate : moveGenerator.generateLegalMoves(board, board.getCurrentTurn())) {
+        Board temp = board;
+        temp.movePiece(candidate.fromRow, candidate.fromCol, candidate.toRow, candidate.toCol, candidate.promotion);
+        if (!EndgameTables::probe(temp, result))
+            return false;
+        int candidateScore = -tableScore(result, 1);
+        if (candidateScore > bestScore) {
+            bestScore = candidateScore;
+            move = candidate;
+        }
+    }
+    score = bestScore;
+    return bestScore > -INF;
+}
+
+int Bot::tableScore(const EndgameTables::Result& result, int ply) {
+    switch (result.outcome) {
+        case EndgameTables::Outcome::WIN: return MATE - ply - result.plies;
+        case EndgameTables::Outcome::LOSS: return -MATE + ply + result.plies;
+        default: return 0;
+    }
+}
+
+// Only won and lost positions: a draw is left to the search, which knows
+// which drawing moves keep the most chances.
+bool Bot::bestSyzygyMove(const Board& board, Move& move, int& score) {
+    if (board.getPieceCount() > std::min(syzygyProbeLimit, Syzygy::maxPieces()))
+        return false;
+    Syzygy::WDL wdl;
+    int dtz;
+    if (!Syzygy::bestMove(board, move, wdl, dtz) || (wdl != Syzygy::WDL::WIN && wdl != Syzygy::WDL::LOSS))
+        return false;
+    score = wdl == Syzygy::WDL::WIN ? TB_WIN - dtz : -TB_WIN - dtz;
+    return true;
+}
+
+// Cursed wins and blessed losses are draws under the fifty-move rule
+int Bot::syzygyScore(Syzygy::WDL wdl, int ply) {
+    switch (wdl) {
+        case Syzygy::WDL::WIN: return TB_WIN - ply;
+        case Syzygy::WDL::LOSS: return -TB_WIN + ply;
+        default: return 0;
+    }
+}
+
+// Moves to mate for a mate score, negative when getting mated; 0 otherwise
+int Bot::mateIn(int score) {
+    if (score >= MATE_BOUND)
+        return (MATE - score + 1) / 2;
+    if (score <= -MATE_BOUND)
+        return -(MATE + score) / 2;
+    return 0;
+}
+
+// Checked before prepareSearch() wakes the helpers, so that an exception
+// is never thrown while they search.
+void Bot::requireLegalMoves(const Board& board) {
+    MoveGenerator moveGenerator;
+    if (moveGenerator.generateLegalMoves(board, board.getCurrentTurn()).empty())
+        throw std::runtime_error("No legal moves available");
+}
+
+// Sets up a search of board under searchLimits and releases the helper
+// threads. The main thread's share of the work is done by runSearch.
+void Bot::prepareSearch(Board& board, const SearchLimits& searchLimits) {
+    limits = searchLimits;
+    moveSource = MoveSource::SEARCH;
+    pondering = limits.ponder;
+    searchSide = board.getCurrentTurn();
+    timeManager.start(limits, searchSide);
+    syzygyPieces = std::min(syzygyProbeLimit, Syzygy::maxPieces());
+    int depth = limits.depth > 0 ? std::min(limits.depth, MAX_DEPTH) : MAX_DEPTH;
+
+    // The table persists across moves; entries from earlier searches are
+    // only aged so they are replaced first.
+    transpositionTable.newSearch();
+    pvLines.clear();
+
+    // Odd helpers search one ply deeper so the threads spread out over
+    // different depths instead of duplicating the main thread's work.
+    for (auto& thread : threads) {
+        thread->nodesSearched = 0;
+        thread->stats = SearchStats();
+        thread->nullMoveMinPly = 0;
+        resetHeuristics(*thread);
+        thread->maxDepth = depth + thread->index % 2;
+        if (thread->index > 0)
+            thread->rootBoard = std::make_unique<Board>(board);
+    }
+
+    stopSearch = false;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        activeHelpers = (int)threads.size() - 1;
+        searchId++;
+    }
+    poolCondition.notify_all();
+}
+
+Move Bot::runSearch(Board& board) {
+    // The main thread's result is the one reported.
+    Move bestMove = iterativeDeepening(*threads[0], board, threads[0]->maxDepth);
+
+    stopSearch = true;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolCondition.wait(lock, [&] { return activeHelpers == 0; });
+    }
+
+    collectStats();
     return bestMove;
 }
 
-Move Bot::iterativeDeepening(Board& board, int maxDepth) {
+// Sums the threads' counters into searchStats. Only called once all threads
+// have stopped.
+void Bot::collectStats() {
+    searchStats = SearchStats();
+    for (const auto& thread : threads) {
+        searchStats.add(thread->stats);
+    }
+    // Every node not counted by quiescence belongs to the main search
+    searchStats.nodes = totalNodes() - searchStats.qnodes;
+
+    const SearchStats& main = threads[0]->stats;
+    searchStats.iterations = main.iterations;
+    searchStats.depth = main.iterations.empty() ? 0 : main.iterations.back().depth;
+    searchStats.threads = (int)threads.size();
+    searchStats.timeMs = timeManager.elapsed();
+    searchStats.hashfull = transpositionTable.hashfull();
+}
+
+Move Bot::iterativeDeepening(SearchThread& thread, Board& board, int maxDepth) {
     MoveGenerator moveGenerator;
     std::vector<Move> moves = moveGenerator.generateLegalMoves(board, board.getCurrentTurn());
     
     if (moves.empty())
         throw std::runtime_error("No legal moves available");
+
+    // Before the first iteration there are no records yet, so start from the
+    // static ordering with the move remembered in the TT in front.
+    int ttScore;
+    Move ttMove;
+    probeTT(board.getHash(), MAX_PLY, -INF, INF, 0, ttScore, ttMove);
+    moves = orderMoves(board, moves);
+    promoteMove(moves, ttMove);
+
+    thread.rootMoves.clear();
+    for (const auto& move : moves) {
+        thread.rootMoves.emplace_back(move);
+    }
     
-    Move bestMove = moves[0];
-    int bestScore = std::numeric_limits<int>::min();
+    Move bestMove = thread.rootMoves[0].move;
+    int bestScore = 0;
+    
+    int bestMoveStability = 0;
     
     // Iterative deepening - start shallow and go deeper
     for (int depth = 1; depth <= maxDepth; depth++) {
-        int currentBestScore = std::numeric_limits<int>::min();
-        Move currentBestMove = bestMove;
-        
-        // Order moves based on previous iteration's best move
-        moves = orderMoves(board, moves);
-        
-        for (const auto &move : moves) {
-            Board temp = board;
-            temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-            int score = minimax(temp, depth - 1, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), false);
-            
-            if (score > currentBestScore) {
-                currentBestScore = score;
-                currentBestMove = move;
+        for (auto& rootMove : thread.rootMoves) {
+            rootMove.previousScore = rootMove.score;
+        }
+
+        // Each line searches the root moves not taken by the lines before it
+        size_t lines = thread.index == 0 ? std::min((size_t)multiPV, thread.rootMoves.size()) : 1;
+        for (size_t pvIndex = 0; pvIndex < lines; pvIndex++) {
+            // Aspiration window: search a narrow window around the previous
+            // score and widen on whichever side fails.
+            int previous = pvIndex == 0 ? bestScore : thread.rootMoves[pvIndex].previousScore;
+            int delta = ASPIRATION_WINDOW;
+            int alpha = -INF, beta = INF;
+            if (depth >= 3 && previous > -INF) {
+                alpha = std::max(previous - delta, -INF);
+                beta = std::min(previous + delta, INF);
+            }
+
+            while (true) {
+                int score = searchRoot(thread, board, depth, alpha, beta, pvIndex);
+                if (stopSearch)
+                    break;
+
+                if (score <= alpha) {
+                    // Fail low: the root move is unreliable, keep the last one
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(score - delta, -INF);
+                } else if (score >= beta) {
+                    beta = std::min(score + delta, INF);
+                    if (pvIndex == 0)
+                        bestMove = thread.rootMoves[0].move;
+                } else {
+                    break;
+                }
+                delta *= 2;
             }
+            if (stopSearch)
+                break;
+
+            // The lines found so far stay sorted best first
+            std::stable_sort(thread.rootMoves.begin(), thread.rootMoves.begin() + pvIndex + 1,
+                             [](const RootMove& a, const RootMove& b) { return a.score > b.score; });
         }
+
+        // An iteration stopped midway has an incomplete result; drop it.
+        if (stopSearch)
+            break;
         
-        bestMove = currentBestMove;
-        bestScore = currentBestScore;
+        bestMoveStability = thread.rootMoves[0].move.sameSquares(bestMove) ? bestMoveStability + 1 : 0;
+        bestMove = thread.rootMoves[0].move;
+        bestScore = thread.rootMoves[0].score;
+
+        if (thread.index == 0) {
+            recordIteration(thread, depth);
+            recordPVLines(thread, depth, lines);
+        }
         
-        std::cout << "Depth " << depth << " completed. Best score: " << bestScore << std::endl;
+        // While pondering the main thread stays quiet and ignores the clock
+        // until ponderHit() or stopPondering().
+        if (thread.index == 0 && !pondering) {
+            reportProgress();
+
+            // Only the main thread manages time; helpers run until stopped.
+            // A forced move needs no more than one iteration.
+            if (timeManager.isTimed() && thread.rootMoves.size() == 1)
+                break;
+            if (timeManager.softLimitReached(bestMoveStability))
+                break;
+        }
     }
     
     return bestMove;
 }
 
-int Bot::minimax(Board &board, int depth, int alpha, int beta, bool maximizingPlayer) {
-    nodesSearched++;
+uint64_t Bot::totalNodes() const {
+    uint64_t nodes = 0;
+    for (const auto& thread : threads) {
+        nodes += thread->nodesSearched.load(std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
+void Bot::recordIteration(SearchThread& thread, int depth) {
+    std::vector<SearchStats::Iteration>& iterations = thread.stats.iterations;
+    uint64_t nodesBefore = 0;
+    for (const auto& iteration : iterations) nodesBefore += iteration.nodes;
+
+    SearchStats::Iteration iteration;
+    iteration.depth = depth;
+    iteration.nodes = totalNodes() - nodesBefore;
+    iteration.timeMs = timeManager.elapsed();
+    if (!iterations.empty() && iterations.back().nodes > 0)
+        iteration.branchingFactor = (double)iteration.nodes / iterations.back().nodes;
+    iterations.push_back(iteration);
+}
+
+void Bot::recordPVLines(SearchThread& thread, int depth, size_t lines) {
+    pvLines.clear();
+    for (size_t i = 0; i < lines; i++) {
+        const RootMove& rootMove = thread.rootMoves[i];
+        SearchInfo info;
+        info.multiPV = (int)i + 1;
+        info.depth = depth;
+        info.score = rootMove.score;
+        info.mateIn = mateIn(rootMove.score);
+        info.nodes = totalNodes();
+        info.timeMs = timeManager.elapsed();
+        info.nps = info.timeMs > 0 ? info.nodes * 1000 / info.timeMs : 0;
+        info.hashfull = transpositionTable.hashfull();
+        info.pv = rootMove.pv;
+        pvLines.push_back(std::move(info));
+    }
+}
+
+void Bot::reportProgress() {
+    if (!progressCallback)
+        return;
+    for (const SearchInfo& info : pvLines) {
+        progressCallback(info);
+    }
+}
+
+// Searches every root move from pvIndex on (the earlier ones belong to
+// MultiPV lines already found) with the running alpha bound, PVS-style, and
+// records each move's score, subtree size and PV. Afterwards those root
+// moves are re-sorted: the best move first, then the rest by subtree size,
+// which is what the next line, iteration or aspiration re-search searches in.
+int Bot::searchRoot(SearchThread& thread, Board& board, int depth, int alpha, int beta, size_t pvIndex) {
+    thread.nodesSearched++;
+    int bestScore = -INF;
+    int originalAlpha = alpha;
+
+    for (size_t i = pvIndex; i < thread.rootMoves.size(); i++) {
+        RootMove& rootMove = thread.rootMoves[i];
+        const Move& move = rootMove.move;
+        uint64_t nodesBefore = thread.nodesSearched;
+
+        Board temp = board;
+        temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+        transpositionTable.prefetch(temp.getHash());
+
+        // The side to move is resolved here once; below it is a template argument
+        auto searchChild = [&](int childAlpha, int childBeta) {
+            return temp.getCurrentTurn() == PieceColor::WHITE
+                ? negamax<PieceColor::WHITE>(thread, temp, depth - 1, childAlpha, childBeta, 1)
+                : negamax<PieceColor::BLACK>(thread, temp, depth - 1, childAlpha, childBeta, 1);
+        };
+
+        int score;
+        if (i == pvIndex) {
+            score = -searchChild(-beta, -alpha);
+        } else {
+            score = -searchChild(-alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+                score = -searchChild(-beta, -alpha);
+        }
+
+        if (stopSearch.load(std::memory_order_relaxed))
+            return 0;
+
+        rootMove.nodes = thread.nodesSearched - nodesBefore;
+
+        // Only the first move and moves that raise alpha have a real score;
+        // the rest only proved they are no better.
+        if (i == pvIndex || score > alpha) {
+            rootMove.score = score;
+            rootMove.pv.assign(1, move);
+            for (int p = 1; p < thread.pvLength[1]; p++) {
+                rootMove.pv.push_back(thread.pv[1][p]);
+            }
+        } else {
+            rootMove.score = -INF;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha)
+                alpha = score;
+        }
+
+        if (alpha >= beta)
+            break;
+    }
+
+    std::stable_sort(thread.rootMoves.begin() + pvIndex, thread.rootMoves.end(), [](const RootMove& a, const RootMove& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.nodes > b.nodes;
+    });
+
+    // Keep the root's best move in the TT, e.g. for a later search of the
+    // same position
+    if (pvIndex == 0 && bestScore > originalAlpha) {
+        TTBound bound = bestScore >= beta ? TTBound::LOWER : TTBound::EXACT;
+        storeTT(board.getHash(), depth, bestScore, bound, 0, thread.rootMoves[0].move);
+    }
+
+    return bestScore;
+}
+
+// Side-relative negamax with fail-soft alpha-beta and principal variation
+// search: the first move gets the full window, later moves a null window
+// that is widened again only when they beat alpha.
+template <PieceColor Us>
+int Bot::negamax(SearchThread& thread, Board &board, int depth, int alpha, int beta, int ply) {
+    if (stopSearch.load(std::memory_order_relaxed))
+        return 0;
+
+    thread.pvLength[ply] = ply;
+
+    if (depth <= 0 || ply >= MAX_PLY - 1)
+        return quiescence<Us>(thread, board, alpha, beta, ply);
+
+    thread.nodesSearched++;
+    checkLimits(thread);
+    bool pvNode = beta - alpha > 1;
     
     // Check transposition table
     uint64_t hash = calculateHash(board);
     Move ttMove;
     int ttScore;
-    if (probeTT(hash, depth, alpha, beta, ttScore, ttMove)) {
-        ttHits++;
+    int originalAlpha = alpha;
+    if (probeTT(hash, depth, alpha, beta, ply, ttScore, ttMove, &thread.stats) && !pvNode) {
+        thread.stats.ttCutoffs++;
         return ttScore;
     }
-    
-    if (depth == 0)
-        return quiescence(board, alpha, beta);
+
+    // With three pieces or fewer the tables know the exact result
+    EndgameTables::Result tableResult;
+    if (useEndgameTables && board.getPieceCount() <= EndgameTables::MAX_PIECES &&
+        EndgameTables::probe(board, tableResult)) {
+        thread.stats.tableHits++;
+        return tableScore(tableResult, ply);
+    }
+
+    Syzygy::WDL wdl;
+    if (board.getPieceCount() <= syzygyPieces && Syzygy::probeWDL(board, wdl)) {
+        thread.stats.tableHits++;
+        return syzygyScore(wdl, ply);
+    }
+
+    constexpr PieceColor Them = ColorTraits<Us>::them;
+    bool inCheck = board.isInCheck(Us);
+
+    // Forward pruning only happens at non-PV nodes out of check, and never
+    // when a mate score is at stake.
+    bool canPrune = !pvNode && !inCheck && beta > -MATE_BOUND && beta < MATE_BOUND;
+    int staticEval = canPrune ? evaluateBoard<Us>(board) : -INF;
+    bool nearLeaf = depth <= PruningMargins::MAX_DEPTH;
+
+    // Reverse futility pruning: far enough above beta that no opponent
+    // reply is expected to bring the score back within the remaining depth.
+    if (canPrune && nearLeaf && staticEval - pruningMargins.reverseFutility[depth] >= beta) {
+        thread.stats.reverseFutilityPrunes++;
+        return staticEval;
+    }
+
+    // Razoring: far enough below alpha that only captures could help, so
+    // ask quiescence and trust it when it agrees.
+    if (canPrune && nearLeaf && staticEval + pruningMargins.razoring[depth] <= alpha) {
+        int score = quiescence<Us>(thread, board, alpha, alpha + 1, ply);
+        if (stopSearch.load(std::memory_order_relaxed))
+            return 0;
+        if (score <= alpha) {
+            thread.stats.razorPrunes++;
+            return score;
+        }
+    }
+
+    // Null-move pruning: if passing and letting the opponent search at
+    // reduced depth still fails high, a real move will too. Unsound in
+    // zugzwang, so not tried right after another null move or with only
+    // pawns left, and verified at high depth.
+    if (canPrune && depth >= NULL_MOVE_MIN_DEPTH && ply >= thread.nullMoveMinPly &&
+        hasMove(board.getLastMove()) && hasNonPawnMaterial(board, Us)) {
+        if (staticEval >= beta) {
+            int reduction = 3 + depth / 6 + std::min(3, (staticEval - beta) / 200);
+
+            Board temp = board;
+            temp.makeNullMove();
+            int score = -negamax<Them>(thread, temp, depth - 1 - reduction, -beta, -beta + 1, ply + 1);
+
+            if (stopSearch.load(std::memory_order_relaxed))
+                return 0;
+
+            if (score >= beta) {
+                // A mate found after passing proves nothing about the real moves
+                if (score >= MATE_BOUND)
+                    score = beta;
+
+                if (depth < NULL_MOVE_VERIFY_DEPTH) {
+                    thread.stats.nullMovePrunes++;
+                    return score;
+                }
+
+                int savedMinPly = thread.nullMoveMinPly;
+                thread.nullMoveMinPly = ply + 3 * (depth - reduction) / 4;
+                int verified = negamax<Us>(thread, board, depth - reduction, beta - 1, beta, ply);
+                thread.nullMoveMinPly = savedMinPly;
+                if (verified >= beta) {
+                    thread.stats.nullMovePrunes++;
+                    return score;
+                }
+            }
+        }
+    }
 
     MoveGenerator moveGenerator;
-    std::vector<Move> moves = moveGenerator.generateLegalMoves(board, board.getCurrentTurn());
+    std::vector<Move> moves = moveGenerator.generateLegalMoves(board, Us);
 
     if (moves.empty())
-        return evaluate(board);
+        return inCheck ? -MATE + ply : 0;
+
+    moves = orderMoves(thread, board, moves, ply);
+    promoteMove(moves, ttMove);
 
     Move bestMove;
-    int bestScore;
+    int bestScore = -INF;
+    std::vector<Move> triedQuiets;
 
-    if (maximizingPlayer) {
-        bestScore = std::numeric_limits<int>::min();
-        moves = orderMoves(board, moves);
-        
-        for (size_t i = 0; i < moves.size(); i++) {
-            const auto &move = moves[i];
-            Board temp = board;
-            temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-            
-            int searchDepth = depth - 1;
-            // Late Move Reduction: reduce depth for later moves if they're not captures
-            if (i > 3 && depth > 2 && !board.getPiece(move.toRow, move.toCol)) {
-                searchDepth = depth - 2;
-            }
-            
-            int eval = minimax(temp, searchDepth, alpha, beta, false);
-            
-            if (eval > bestScore) {
-                bestScore = eval;
-                bestMove = move;
-            }
-            
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha)
-                break; // Alpha-beta cutoff
+    for (size_t i = 0; i < moves.size(); i++) {
+        const auto &move = moves[i];
+        bool quiet = !board.getPiece(move.toRow, move.toCol);
+        bool losingCapture = !quiet && !staticExchangeAtLeast(board, move, 0);
+
+        // SEE pruning: near the leaves, skip captures that lose material
+        // and quiet moves that put the piece where it is simply lost.
+        if (canPrune && nearLeaf && i > 0 &&
+            !staticExchangeAtLeast(board, move, quiet ? -pruningMargins.seeQuiet[depth] : -pruningMargins.seeCapture[depth])) {
+            thread.stats.seePrunes++;
+            continue;
         }
-    } else {
-        bestScore = std::numeric_limits<int>::max();
-        moves = orderMoves(board, moves);
-        
-        for (size_t i = 0; i < moves.size(); i++) {
-            const auto &move = moves[i];
-            Board temp = board;
-            temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-            
-            int searchDepth = depth - 1;
-            // Late Move Reduction
-            if (i > 3 && depth > 2 && !board.getPiece(move.toRow, move.toCol)) {
-                searchDepth = depth - 2;
+
+        Board temp = board;
+        temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+
+        // Futility pruning: a quiet move that cannot lift the static eval to
+        // alpha is skipped, unless it gives check or promotes. The first
+        // move is always searched so the node keeps a real score.
+        if (canPrune && nearLeaf && quiet && i > 0 &&
+            staticEval + pruningMargins.futility[depth] <= alpha &&
+            !isPromotion(board, move) && !temp.isInCheck(Them)) {
+            thread.stats.futilityPrunes++;
+            bestScore = std::max(bestScore, staticEval + pruningMargins.futility[depth]);
+            continue;
+        }
+
+        transpositionTable.prefetch(temp.getHash());
+
+        int score;
+        if (i == 0) {
+            score = -negamax<Them>(thread, temp, depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            // Late Move Reduction: reduce depth for later quiet moves and
+            // losing captures
+            int reduction = (i > 3 && depth > 2 && (quiet || losingCapture)) ? 1 : 0;
+            if (reduction > 0)
+                thread.stats.lmrReductions++;
+
+            score = -negamax<Them>(thread, temp, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && reduction > 0) {
+                thread.stats.lmrResearches++;
+                score = -negamax<Them>(thread, temp, depth - 1, -alpha - 1, -alpha, ply + 1);
             }
-            
-            int eval = minimax(temp, searchDepth, alpha, beta, true);
-            
-            if (eval < bestScore) {
-                bestScore = eval;
+            if (score > alpha && score < beta)
+                score = -negamax<Them>(thread, temp, depth - 1, -beta, -alpha, ply + 1);
+        }
+
+        if (stopSearch.load(std::memory_order_relaxed))
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
                 bestMove = move;
+
+                // Extend the PV with the child's line
+                thread.pv[ply][ply] = move;
+                for (int p = ply + 1; p < thread.pvLength[ply + 1]; p++) {
+                    thread.pv[ply][p] = thread.pv[ply + 1][p];
+                }
+                thread.pvLength[ply] = thread.pvLength[ply + 1];
             }
-            
-            beta = std::min(beta, eval);
-            if (beta <= alpha)
-                break; // Alpha-beta cutoff
         }
+
+        if (alpha >= beta) {
+            thread.stats.betaCutoffs++;
+            thread.stats.cutoffsByMove[std::min<size_t>(i, SearchStats::CUTOFF_SLOTS - 1)]++;
+            if (quiet)
+                updateQuietHeuristics(thread, board, move, triedQuiets, depth, ply);
+            break;
+        }
+
+        if (quiet)
+            triedQuiets.push_back(move);
     }
-    
+
     // Store in transposition table
-    storeTT(hash, depth, bestScore, bestMove);
+    TTBound bound = TTBound::EXACT;
+    if (bestScore >= beta) bound = TTBound::LOWER;
+    else if (bestScore <= originalAlpha) bound = TTBound::UPPER;
+    storeTT(hash, depth, bestScore, bound, ply, bestMove);
     
     return bestScore;
 }
 
 
-int Bot::quiescence(Board &board, int alpha, int beta) {
-    int standPat = evaluate(board);
+// Cheap enough to call at every node: the clock is only read every 1024
+// nodes, and only by the main thread, which then stops all threads.
+void Bot::checkLimits(SearchThread& thread) {
+    if (thread.index != 0 || (thread.nodesSearched & 1023) != 0 || pondering)
+        return;
 
-    if (standPat >= beta)
-        return beta;
-    if (alpha < standPat)
-        alpha = standPat;
+    if (timeManager.hardLimitReached() ||
+        (limits.nodes > 0 && (uint64_t)thread.nodesSearched >= limits.nodes)) {
+        stopSearch = true;
+    }
+}
+
+// Resolves captures and promotions until the position is quiet. Out of
+// check the side to move may stand pat on the static eval and only tries
+// noisy moves that could still raise alpha and do not lose material by SEE;
+// in check every evasion is searched and there is no stand pat.
+template <PieceColor Us>
+int Bot::quiescence(SearchThread& thread, Board &board, int alpha, int beta, int ply) {
+    if (stopSearch.load(std::memory_order_relaxed))
+        return 0;
+
+    thread.nodesSearched++;
+    thread.stats.qnodes++;
+    checkLimits(thread);
+
+    bool inCheck = board.isInCheck(Us);
+    if (ply >= MAX_PLY - 1)
+        return inCheck ? 0 : evaluateBoard<Us>(board);
+
+    bool pvNode = beta - alpha > 1;
+    uint64_t hash = board.getHash();
+    Move ttMove;
+    int ttScore;
+    if (probeTT(hash, 0, alpha, beta, ply, ttScore, ttMove, &thread.stats) && !pvNode) {
+        thread.stats.ttCutoffs++;
+        return ttScore;
+    }
 
+    int originalAlpha = alpha;
+    int bestScore = -INF;
+    int standPat = -INF;
     MoveGenerator moveGenerator;
-    auto moves = moveGenerator.generateLegalMoves(board, board.getCurrentTurn());
+    std::vector<Move> moves;
 
-    for (const auto &move : moves) {
-        Piece *captured = board.getPiece(move.toRow, move.toCol);
-        if (!captured)
-            continue;
+    if (inCheck) {
+        moves = moveGenerator.generateLegalMoves(board, Us);
+        if (moves.empty())
+            return -MATE + ply;
+        moves = orderMoves(thread, board, moves, ply);
+    } else {
+        standPat = evaluateBoard<Us>(board);
+        if (standPat >= beta) {
+            storeTT(hash, 0, standPat, TTBound::LOWER, ply, Move());
+            return standPat;
+        }
+        if (alpha < standPat)
+            alpha = standPat;
+        bestScore = standPat;
+
+        // Delta pruning: skip moves that cannot raise alpha even if the
+        // captured piece (and any promotion) came for free, with a margin
+        // for positional gains. SEE drops the ones that lose material.
+        std::vector<std::pair<Move, int>> scored;
+        for (const auto &move : moveGenerator.generateNoisyMoves(board, Us)) {
+            Piece* captured = board.getPiece(move.toRow, move.toCol);
+            int gain = captured ? seePieceValue(captured->getType()) : 0;
+            if (isPromotion(board, move))
+                gain += seePieceValue(PieceType::QUEEN) - seePieceValue(PieceType::PAWN);
+            if (standPat + gain + DELTA_MARGIN <= alpha)
+                continue;
+            if (!staticExchangeAtLeast(board, move, 0))
+                continue;
+            scored.emplace_back(move, gain * 10 + captureOrderingScore(board, move));
+        }
+        std::stable_sort(scored.begin(), scored.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+        for (const auto &[move, _] : scored) moves.push_back(move);
+    }
+    promoteMove(moves, ttMove);
 
+    Move bestMove;
+    for (const auto &move : moves) {
         Board temp = board;
         temp.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-        int score = -quiescence(temp, -beta, -alpha);
+        transpositionTable.prefetch(temp.getHash());
+        int score = -quiescence<ColorTraits<Us>::them>(thread, temp, -beta, -alpha, ply + 1);
 
-        if (score >= beta)
-            return beta;
-        if (score > alpha)
-            alpha = score;
+        if (stopSearch.load(std::memory_order_relaxed))
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+            }
+        }
+        if (alpha >= beta)
+            break;
     }
-    return alpha;
+
+    TTBound bound = TTBound::EXACT;
+    if (bestScore >= beta) bound = TTBound::LOWER;
+    else if (bestScore <= originalAlpha) bound = TTBound::UPPER;
+    storeTT(hash, 0, bestScore, bound, ply, bestMove);
+
+    return bestScore;
 }
 
 std::vector<Move> Bot::orderMoves(Board& board, const std::vector<Move>& moves) {
@@ -194,17 +949,92 @@ std::vector<Move> Bot::orderMoves(Board& board, const std::vector<Move>& moves)
     return orderedMoves;
 }
 
+// Search-time ordering: the static scores, with the killers, the
+// countermove and the history table deciding among the quiet moves.
+std::vector<Move> Bot::orderMoves(SearchThread& thread, Board& board, const std::vector<Move>& moves, int ply) {
+    int side = board.getCurrentTurn() == PieceColor::WHITE ? 0 : 1;
+    Move previous = board.getLastMove();
+    const Move& counterMove = thread.counterMoves[previous.fromRow * 8 + previous.fromCol][previous.toRow * 8 + previous.toCol];
+
+    std::vector<std::pair<Move, int>> scoredMoves;
+    for (const auto& move : moves) {
+        int score = getMoveOrderingScore(board, move);
+        if (!board.getPiece(move.toRow, move.toCol)) {
+            if (move.sameSquares(thread.killers[ply][0]))
+                score += KILLER_SCORE + 1;
+            else if (move.sameSquares(thread.killers[ply][1]))
+                score += KILLER_SCORE;
+            else if (hasMove(previous) && move.sameSquares(counterMove))
+                score += COUNTER_MOVE_SCORE;
+            else
+                score += thread.history[side][move.fromRow * 8 + move.fromCol][move.toRow * 8 + move.toCol];
+        }
+        scoredMoves.emplace_back(move, score);
+    }
+
+    std::stable_sort(scoredMoves.begin(), scoredMoves.end(),
+                     [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    std::vector<Move> orderedMoves;
+    orderedMoves.reserve(scoredMoves.size());
+    for (const auto& [move, _] : scoredMoves) {
+        orderedMoves.push_back(move);
+    }
+
+    return orderedMoves;
+}
+
+// Called when a quiet move causes a beta cutoff. History uses the gravity
+// formula, which keeps entries within +-MAX_HISTORY and lets stale values
+// decay: the cutoff move gains depth^2, every quiet move tried before it
+// loses as much.
+void Bot::updateQuietHeuristics(SearchThread& thread, Board& board, const Move& move,
+                                const std::vector<Move>& triedQuiets, int depth, int ply) {
+    if (!move.sameSquares(thread.killers[ply][0])) {
+        thread.killers[ply][1] = thread.killers[ply][0];
+        thread.killers[ply][0] = move;
+    }
+
+    Move previous = board.getLastMove();
+    if (hasMove(previous))
+        thread.counterMoves[previous.fromRow * 8 + previous.fromCol][previous.toRow * 8 + previous.toCol] = move;
+
+    int side = board.getCurrentTurn() == PieceColor::WHITE ? 0 : 1;
+    int bonus = std::min(depth * depth, 1200);
+    auto update = [&](const Move& m, int delta) {
+        int& entry = thread.history[side][m.fromRow * 8 + m.fromCol][m.toRow * 8 + m.toCol];
+        entry += delta - entry * std::abs(delta) / MAX_HISTORY;
+    };
+
+    update(move, bonus);
+    for (const auto& tried : triedQuiets) {
+        update(tried, -bonus);
+    }
+}
+
+// Killers and countermoves belong to a position, so they are dropped between
+// searches; history is halved so it still seeds the next search.
+void Bot::resetHeuristics(SearchThread& thread) {
+    for (auto& slots : thread.killers) {
+        slots[0] = slots[1] = Move();
+    }
+    for (auto& row : thread.counterMoves) {
+        for (auto& move : row) move = Move();
+    }
+    for (auto& side : thread.history) {
+        for (auto& from : side) {
+            for (int& entry : from) entry /= 2;
+        }
+    }
+}
+
 int Bot::getMoveOrderingScore(Board& board, const Move& move) {
     int score = 0;
     
-    // Prioritize captures
-    Piece* captured = board.getPiece(move.toRow, move.toCol);
-    if (captured) {
-        Piece* moving = board.getPiece(move.fromRow, move.fromCol);
-        if (moving) {
-            // MVV-LVA (Most Valuable Victim - Least Valuable Attacker)
-            score += 1000 + (int)captured->getType() * 100 - (int)moving->getType() * 10;
-        }
+    // Prioritize captures, unless they lose material
+    if (board.getPiece(move.toRow, move.toCol)) {
+        int band = staticExchangeAtLeast(board, move, 0) ? CAPTURE_SCORE : BAD_CAPTURE_SCORE;
+        score += band + captureOrderingScore(board, move);
     }
     
     // Opening principles bonus (includes penalties for bad moves)
@@ -233,6 +1063,38 @@ int Bot::getMoveOrderingScore(Board& board, const Move& move) {
     return score;
 }
 
+// evaluate() scores from white's side; the search is side-relative
+template <PieceColor Us>
+int Bot::evaluateBoard(const Board& board) {
+    return ColorTraits<Us>::sign * evaluate(board, evalParams, nullptr);
+}
+
+bool Bot::isPromotion(const Board& board, const Move& move) {
+    Piece* piece = board.getPiece(move.fromRow, move.fromCol);
+    return piece && piece->getType() == PieceType::PAWN && (move.toRow == 0 || move.toRow == 7);
+}
+
+bool Bot::hasNonPawnMaterial(const Board& board, PieceColor color) {
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.getPiece(row, col);
+            if (piece && piece->getColor() == color &&
+                piece->getType() != PieceType::PAWN && piece->getType() != PieceType::KING) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// MVV-LVA (Most Valuable Victim - Least Valuable Attacker) on piece values
+int Bot::captureOrderingScore(const Board& board, const Move& move) {
+    Piece* captured = board.getPiece(move.toRow, move.toCol);
+    Piece* moving = board.getPiece(move.fromRow, move.fromCol);
+    if (!captured || !moving) return 0;
+    return seePieceValue(captured->getType()) * 10 - seePieceValue(moving->getType()) / 10;
+}
+
 bool Bot::isGoodOpeningMove(Board& board, const Move& move) {
     Piece* piece = board.getPiece(move.fromRow, move.fromCol);
     if (!piece) return false;
@@ -363,47 +1225,56 @@ bool Bot::isEndgamePhase(const Board& board) {
 }
 
 uint64_t Bot::calculateHash(const Board& board) {
-    // Simple hash function - in a real engine you'd use Zobrist hashing
-    uint64_t hash = 0;
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            Piece* piece = board.getPiece(row, col);
-            if (piece) {
-                hash ^= ((uint64_t)piece->getType() << (row * 8 + col)) + 
-                       ((uint64_t)piece->getColor() << (row * 8 + col + 32));
-            }
-        }
-    }
-    hash ^= (uint64_t)board.getCurrentTurn() << 60;
-    return hash;
+    return board.getHash();
 }
 
-bool Bot::probeTT(uint64_t hash, int depth, int alpha, int beta, int& score, Move& bestMove) {
-    int index = hash % TT_SIZE;
-    TranspositionEntry& entry = transpositionTable[index];
-    
-    if (!entry.isValid) return false;
-    
-    if (entry.depth >= depth) {
-        score = entry.score;
-        bestMove = entry.bestMove;
-        
-        // Check if we can use this score
-        if (score <= alpha || score >= beta) {
-            return true;
-        }
+// Mate scores are stored relative to the node rather than the root, so a
+// mate found through a transposition keeps the right distance.
+int Bot::scoreToTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int Bot::scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
+bool Bot::probeTT(uint64_t hash, int depth, int alpha, int beta, int ply, int& score, Move& bestMove,
+                  SearchStats* stats) {
+    TTEntry entry;
+    if (stats) stats->ttProbes++;
+    if (!transpositionTable.probe(hash, entry)) return false;
+    if (stats) stats->ttHits++;
+
+    // The move is useful for ordering even when the score is not
+    bestMove = entry.bestMove;
+    if (entry.depth < depth) return false;
+
+    score = scoreFromTT(entry.score, ply);
+    switch (entry.bound) {
+        case TTBound::EXACT: return true;
+        case TTBound::LOWER: return score >= beta;
+        case TTBound::UPPER: return score <= alpha;
+        default: return false;
     }
-    
-    return false;
 }
 
-void Bot::storeTT(uint64_t hash, int depth, int score, const Move& bestMove) {
-    int index = hash % TT_SIZE;
-    TranspositionEntry& entry = transpositionTable[index];
-    
-    // Always replace (simple replacement scheme)
-    entry.score = score;
-    entry.depth = depth;
-    entry.bestMove = bestMove;
-    entry.isValid = true;
+void Bot::storeTT(uint64_t hash, int depth, int score, TTBound bound, int ply, const Move& bestMove) {
+    transpositionTable.store(hash, depth, scoreToTT(score, ply), bound, bestMove);
+}
+
+bool Bot::hasMove(const Move& move) {
+    return move.fromRow != move.toRow || move.fromCol != move.toCol;
+}
+
+void Bot::promoteMove(std::vector<Move>& moves, const Move& move) {
+    for (size_t i = 0; i < moves.size(); i++) {
+        if (moves[i].sameSquares(move)) {
+            std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+            return;
+        }
+    }
 }
@@ -2,64 +2,365 @@
 
 #include "../core/board.h"
 #include "../core/move.h"
+#include "endgame_tables.h"
+#include "evaluate.h"
+#include "polyglot.h"
+#include "search_stats.h"
+#include "syzygy.h"
+#include "time_manager.h"
+#include "transposition.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 
+// Depth-indexed margins (centipawns) for the pruning rules applied in the
+// last plies before the horizon. Index 0 is unused.
+struct PruningMargins {
+    static const int MAX_DEPTH = 3;
+
+    int reverseFutility[MAX_DEPTH + 1] = { 0, 90, 180, 270 };
+    int futility[MAX_DEPTH + 1] = { 0, 120, 220, 320 };
+    int razoring[MAX_DEPTH + 1] = { 0, 300, 500, 700 };
+    // Moves whose static exchange loses more than this are skipped
+    int seeCapture[MAX_DEPTH + 1] = { 0, 100, 200, 300 };
+    int seeQuiet[MAX_DEPTH + 1] = { 0, 50, 100, 150 };
+};
+
+// Progress report for one completed iteration of the main search thread,
+// or for one of its lines in MultiPV mode.
+struct SearchInfo {
+    int multiPV = 1;            // rank of the line, 1 = best
+    int depth = 0;
+    int score = 0;              // centipawns from the side to move's view
+    int mateIn = 0;             // moves until mate (negative: getting mated), 0 if none
+    uint64_t nodes = 0;         // all threads
+    int64_t timeMs = 0;
+    uint64_t nps = 0;
+    int hashfull = 0;           // permille of the TT written during this search
+    std::vector<Move> pv;
+};
+
+// Where the move returned by the last search came from
+enum class MoveSource { SEARCH, BOOK, ENDGAME_TABLES };
+
 class Bot {
 public:
-    Bot() : nodesSearched(0), ttHits(0) {
-        // Initialize transposition table
-        transpositionTable.resize(TT_SIZE);
-        for (int i = 0; i < TT_SIZE; i++) {
-            transpositionTable[i].isValid = false;
-        }
-    }
-    
+    using ProgressCallback = std::function<void(const SearchInfo&)>;
+
+    Bot();
+    ~Bot();
+    Bot(const Bot&) = delete;
+    Bot& operator=(const Bot&) = delete;
+
+    // Searches board under limits. If stats is given, the search's
+    // statistics are copied there (see also getSearchStats()).
+    Move findBestMove(Board& board, const SearchLimits& limits, SearchStats* stats = nullptr);
     Move findBestMove(Board& board, int depth);
 
+    // Aborts a running search from another thread; findBestMove then returns
+    // the best move of the last completed iteration.
+    void stop() { stopSearch = true; }
+
+    // Asynchronous search: start() searches a copy of board on a background
+    // thread and returns at once. wait() blocks until that search ends, by
+    // its limits or stop(), and returns its move (or rethrows its error).
+    // Starting another search first cancels a running one.
+    void start(const Board& board, const SearchLimits& limits);
+    Move wait();
+    bool isSearching() const { return backgroundThread.joinable(); }
+
+    // Nodes searched by all threads in the running or last search.
+    uint64_t getNodesSearched() const { return totalNodes(); }
+
+    // Statistics of the last finished search, including ponder searches and
+    // searches started with start().
+    const SearchStats& getSearchStats() const { return searchStats; }
+    MoveSource getMoveSource() const { return moveSource; }
+
+    // Called on the main search thread after every completed iteration,
+    // once per MultiPV line, except while pondering. Must not start or stop
+    // searches itself.
+    void setProgressCallback(ProgressCallback callback) { progressCallback = std::move(callback); }
+
+    // Pondering: while the opponent thinks, search the position after their
+    // expected reply in the background. If they play it, ponderHit() turns
+    // the ponder search into the real one under limits, with the clock
+    // starting at the hit, and wait() returns its move. Otherwise
+    // stopPondering() ends it quickly; the TT keeps what it found. Starting
+    // any other search stops pondering first. Returns false, without
+    // pondering, if there is no reply to expect or it ends the game.
+    bool startPondering(const Board& board, const Move& expectedReply, const SearchLimits& limits);
+    void stopPondering();
+    bool isPondering() const { return backgroundThread.joinable() && pondering; }
+
+    // Ends ponder mode of the running search, whether started by
+    // startPondering() or by a search with limits.ponder set. Safe to call
+    // from any thread.
+    void ponderHit();
+    const Move& getPonderingMove() const { return ponderMove; }
+
+    // Expected reply to the last search's best move, played on board: the
+    // second PV move, or the TT move after the best move. from == to if
+    // there is none.
+    Move getPonderMove(const Board& board);
+
+    // Lazy SMP: the calling thread searches alongside count - 1 persistent
+    // helper threads that share the transposition table.
+    void setThreads(int count);
+    int getThreads() const { return (int)threads.size(); }
+
+    // Transposition table size ("Hash") in megabytes. Resizing clears it.
+    void setHashSize(size_t megabytes, bool hugePages = true);
+    size_t getHashSize() const { return transpositionTable.sizeMB(); }
+
+    void clearHash() { transpositionTable.clear(); }
+
+    // Forgets everything earlier searches learned: the transposition table
+    // and the move-ordering history, which otherwise carries over (halved)
+    // from one search to the next. Afterwards a search depends only on its
+    // position and limits.
+    void newGame();
+
+    // Persistent hash (see TranspositionTable): write the table to a file,
+    // read one back, or keep the table in a memory-mapped file. Not while a
+    // search is running.
+    void saveHash(const std::string& path) const { transpositionTable.save(path); }
+    void loadHash(const std::string& path) { transpositionTable.load(path); }
+    void mapHash(const std::string& path, size_t megabytes) { transpositionTable.mapFile(path, megabytes); }
+
+    // Opening book consulted before searching, except by infinite and ponder
+    // searches. A book move is returned at once, with empty statistics and
+    // no ponder move. nullptr turns the book off.
+    void setBook(std::shared_ptr<const PolyglotBook> openingBook) { book = std::move(openingBook); }
+
+    // Endgame tables (see EndgameTables) resolve positions with three pieces
+    // or fewer inside the search, and at the root pick the move with the
+    // best distance to mate without searching, under the same rules as the
+    // book. Such a move is reported to the progress callback as a depth 0
+    // line with its mate score (or 0 for a draw). On by default.
+    void setEndgameTables(bool enabled) { useEndgameTables = enabled; }
+    bool getEndgameTables() const { return useEndgameTables; }
+
+    // Syzygy tablebases (loaded with Syzygy::init) are probed for the
+    // win/draw/loss result inside the search, in positions with at most
+    // pieces pieces (capped by the largest table found) and no castling
+    // rights. At the root a won or lost position is played from the DTZ
+    // tables without searching, reported like an endgame table move with a
+    // score just below the mate scores; drawn ones are searched. 0 turns
+    // the probes off; the default is Syzygy::MAX_PIECES.
+    void setSyzygyProbeLimit(int pieces) { syzygyProbeLimit = std::clamp(pieces, 0, Syzygy::MAX_PIECES); }
+    int getSyzygyProbeLimit() const { return syzygyProbeLimit; }
+
+    // MultiPV: every iteration of the main thread searches the best count
+    // root moves one after another, each as its own line with a full
+    // window, excluding the lines before it. The lines share the TT and
+    // move ordering, so later ones mostly re-use the first one's work.
+    // Helper threads keep searching the best line only.
+    void setMultiPV(int count) { multiPV = std::max(1, count); }
+    int getMultiPV() const { return multiPV; }
+
+    // The scored lines of the last completed iteration, best first: at most
+    // getMultiPV() of them, fewer if there are fewer legal moves, none
+    // after a book move and the one table line after a table move.
+    const std::vector<SearchInfo>& getPVLines() const { return pvLines; }
+
+    void setPruningMargins(const PruningMargins& margins) { pruningMargins = margins; }
+    const PruningMargins& getPruningMargins() const { return pruningMargins; }
+
+    // Evaluation weights, defaultEvalParams unless set. Not during a search.
+    void setEvalParams(const EvalParams& params) { evalParams = params; }
+    const EvalParams& getEvalParams() const { return evalParams; }
+
 private:
-    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer);
-    int quiescence(Board& board, int alpha, int beta);
-    std::vector<Move> generateNoisyMoves(Board& board, bool whiteToMove);
+    // Scores are side-relative centipawns, bounded by INF. A mate n plies
+    // from the root scores MATE - n.
+    static constexpr int INF = 32000;
+    static constexpr int MATE = 31000;
+    static constexpr int MATE_BOUND = MATE - 1000;
+    static constexpr int ASPIRATION_WINDOW = 50;
+
+    static constexpr int MAX_PLY = 128;
+    // A tablebase win n plies from the root scores TB_WIN - n, below every
+    // mate score
+    static constexpr int TB_WIN = MATE_BOUND - MAX_PLY - 1;
+    static constexpr int MAX_DEPTH = 64;
+
+    // Move ordering bands: captures, then killers and the countermove, then
+    // the remaining quiet moves by history plus their static bonuses.
+    // Captures that lose material by SEE go after all quiet moves.
+    static constexpr int CAPTURE_SCORE = 100000;
+    static constexpr int BAD_CAPTURE_SCORE = -100000;
+    static constexpr int KILLER_SCORE = 90000;
+    static constexpr int COUNTER_MOVE_SCORE = 80000;
+    static constexpr int MAX_HISTORY = 16384;
+
+    // Null-move pruning is tried from NULL_MOVE_MIN_DEPTH; from
+    // NULL_MOVE_VERIFY_DEPTH a fail high is confirmed by a reduced search
+    // without null moves, which catches zugzwang.
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3;
+    static constexpr int NULL_MOVE_VERIFY_DEPTH = 10;
+
+    // Quiescence delta pruning allowance for positional gains
+    static constexpr int DELTA_MARGIN = 200;
+
+    // What the last root search learned about one root move. Between
+    // iterations, root moves are ordered by these records.
+    struct RootMove {
+        explicit RootMove(const Move& move) : move(move) {}
+
+        Move move;
+        int score = -INF;       // -INF unless the move was searched with an open window
+        int previousScore = -INF;   // score after the previous iteration
+        uint64_t nodes = 0;     // size of the move's subtree
+        std::vector<Move> pv;
+    };
+
+    // Per-thread search state. Helpers search their own copy of the root and
+    // only communicate with the main thread through the transposition table.
+    struct SearchThread {
+        explicit SearchThread(int index) : index(index) {}
+
+        int index;
+        std::unique_ptr<Board> rootBoard;
+        int maxDepth = 0;
+        std::vector<RootMove> rootMoves;
+
+        // Triangular PV table: pv[ply] holds the line from ply onwards
+        Move pv[MAX_PLY + 1][MAX_PLY + 1];
+        int pvLength[MAX_PLY + 1] = {};
+
+        // Quiet-move ordering learned during search: two killer slots per
+        // ply, butterfly history per side and from/to square, and the quiet
+        // move that last refuted each previous move (by its from/to squares).
+        Move killers[MAX_PLY + 1][2];
+        int history[2][64][64] = {};
+        Move counterMoves[64][64];
+
+        // Null moves are disabled below this ply while a null-move fail high
+        // is being verified.
+        int nullMoveMinPly = 0;
+
+        uint64_t lastSearchId = 0;
+        std::thread thread;
+
+        // Performance tracking. nodesSearched counts every node, quiescence
+        // included, and is read by the main thread for limits and progress.
+        std::atomic<uint64_t> nodesSearched{0};
+        SearchStats stats;
+    };
+
+    int searchRoot(SearchThread& thread, Board& board, int depth, int alpha, int beta, size_t pvIndex = 0);
+    // Specialised on Us, the side to move in board, and calling the
+    // opponent's instance for the children
+    template <PieceColor Us>
+    int negamax(SearchThread& thread, Board& board, int depth, int alpha, int beta, int ply);
+    template <PieceColor Us>
+    int quiescence(SearchThread& thread, Board& board, int alpha, int beta, int ply);
+    void checkLimits(SearchThread& thread);
+    template <PieceColor Us>
     int evaluateBoard(const Board& board);
-    
+    bool hasNonPawnMaterial(const Board& board, PieceColor color);
+    static bool isPromotion(const Board& board, const Move& move);
+
     // Enhanced move ordering
     std::vector<Move> orderMoves(Board& board, const std::vector<Move>& moves);
+    std::vector<Move> orderMoves(SearchThread& thread, Board& board, const std::vector<Move>& moves, int ply);
+    void updateQuietHeuristics(SearchThread& thread, Board& board, const Move& move,
+                               const std::vector<Move>& triedQuiets, int depth, int ply);
+    void resetHeuristics(SearchThread& thread);
+    void promoteMove(std::vector<Move>& moves, const Move& move);
     int getMoveOrderingScore(Board& board, const Move& move);
-    
+    static int captureOrderingScore(const Board& board, const Move& move);
+
     // Opening principles
     bool isGoodOpeningMove(Board& board, const Move& move);
     int getOpeningBonus(Board& board, const Move& move);
-    
+
     // Enhanced evaluation helpers
     int evaluateKingSafety(const Board& board, PieceColor color);
     int evaluatePawnStructure(const Board& board, PieceColor color);
     int evaluatePieceActivity(const Board& board, PieceColor color);
-    
+
     // Game phase detection
     bool isOpeningPhase(const Board& board);
     bool isEndgamePhase(const Board& board);
-    
+
     // Performance optimizations
-    struct TranspositionEntry {
-        int score;
-        int depth;
-        Move bestMove;
-        bool isValid;
-    };
-    
-    // Simple hash table for transposition table
-    static const int TT_SIZE = 65536; // 64K entries (much smaller)
-    std::vector<TranspositionEntry> transpositionTable;
-    
+    static const size_t DEFAULT_HASH_MB = 16; // kept across moves
+    TranspositionTable transpositionTable;
+
     uint64_t calculateHash(const Board& board);
-    bool probeTT(uint64_t hash, int depth, int alpha, int beta, int& score, Move& bestMove);
-    void storeTT(uint64_t hash, int depth, int score, const Move& bestMove);
-    
+    bool probeTT(uint64_t hash, int depth, int alpha, int beta, int ply, int& score, Move& bestMove,
+                 SearchStats* stats = nullptr);
+    void storeTT(uint64_t hash, int depth, int score, TTBound bound, int ply, const Move& bestMove);
+    static int scoreToTT(int score, int ply);
+    static int scoreFromTT(int score, int ply);
+    static bool hasMove(const Move& move);
+
+    bool findInstantMove(const Board& board, const SearchLimits& limits, Move& move);
+    bool bestTableMove(const Board& board, Move& move, int& score);
+    static int tableScore(const EndgameTables::Result& result, int ply);
+    bool bestSyzygyMove(const Board& board, Move& move, int& score);
+    static int syzygyScore(Syzygy::WDL wdl, int ply);
+    static int mateIn(int score);
+
     // Iterative deepening
-    Move iterativeDeepening(Board& board, int maxDepth);
-    
-    // Performance tracking
-    int nodesSearched;
-    int ttHits;
+    static void requireLegalMoves(const Board& board);
+    void prepareSearch(Board& board, const SearchLimits& limits);
+    Move runSearch(Board& board);
+    void cancelBackgroundSearch();
+    uint64_t totalNodes() const;
+    void collectStats();
+    void recordIteration(SearchThread& thread, int depth);
+    void recordPVLines(SearchThread& thread, int depth, size_t lines);
+    void reportProgress();
+    Move iterativeDeepening(SearchThread& thread, Board& board, int maxDepth);
+
+    // Thread pool. Helpers park on poolCondition between searches and are
+    // released by bumping searchId.
+    void helperLoop(SearchThread* helper);
+    void stopHelpers();
+
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    std::mutex poolMutex;
+    std::condition_variable poolCondition;
+    uint64_t searchId = 0;
+    int activeHelpers = 0;
+    bool quitHelpers = false;
+    std::atomic<bool> stopSearch{false};
+
+    SearchLimits limits;
+    TimeManager timeManager;
+
+    // Background search started by start() or startPondering()
+    std::thread backgroundThread;
+    std::unique_ptr<Board> backgroundBoard;
+    Move backgroundResult;
+    std::exception_ptr backgroundError;
+    Move ponderMove;
+    std::atomic<bool> pondering{false};     // ponder search running, clock not started
+
+    PieceColor searchSide = PieceColor::WHITE;
+
+    std::shared_ptr<const PolyglotBook> book;
+    std::mt19937_64 bookRandom{std::random_device{}()};
+    bool useEndgameTables = true;
+    int syzygyProbeLimit = Syzygy::MAX_PIECES;
+    int syzygyPieces = 0;               // probe limit of the current search
+
+    ProgressCallback progressCallback;
+    int multiPV = 1;
+    std::vector<SearchInfo> pvLines;
+    SearchStats searchStats;
+    MoveSource moveSource = MoveSource::SEARCH;
+    PruningMargins pruningMargins;
+    EvalParams evalParams = defaultEvalParams;
 };
@@ -0,0 +1,322 @@
+#include "endgame_tables.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Tables are stored with the stronger side as white, on squares row * 8 +
+// col in Board's orientation (row 0 = rank 8), indexed by side to move
+// (0 = white), white king, black king and white piece. A value v > 0 means
+// the side to move mates in v plies, v < 0 that it is mated in -v - 1
+// plies, and 0 a draw.
+namespace {
+    using Table = std::vector<int16_t>;
+
+    const int16_t ILLEGAL = INT16_MIN;
+    const int TABLE_SIZE = 2 * 64 * 64 * 64;
+
+    int tableIndex(int stm, int wk, int bk, int x) {
+        return ((stm * 64 + wk) * 64 + bk) * 64 + x;
+    }
+
+    int rowOf(int square) { return square / 8; }
+    int colOf(int square) { return square % 8; }
+
+    bool adjacent(int a, int b) {
+        return std::abs(rowOf(a) - rowOf(b)) <= 1 && std::abs(colOf(a) - colOf(b)) <= 1;
+    }
+
+    const int KING_STEPS[8][2] = { {-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1} };
+
+    // Rook directions first, so a rook uses the first four
+    const int SLIDER_STEPS[8][2] = { {-1,0}, {1,0}, {0,-1}, {0,1}, {-1,-1}, {-1,1}, {1,-1}, {1,1} };
+
+    int directionCount(PieceType type) {
+        return type == PieceType::QUEEN ? 8 : 4;
+    }
+
+    // Squares one step from square in each direction (-1 off the board)
+    int step(int square, const int (&direction)[2]) {
+        int row = rowOf(square) + direction[0], col = colOf(square) + direction[1];
+        return (row < 0 || row > 7 || col < 0 || col > 7) ? -1 : row * 8 + col;
+    }
+
+    // Whether the white piece on x attacks target, with blocker the only
+    // other piece in the way.
+    bool attacks(PieceType type, int x, int target, int blocker) {
+        if (type == PieceType::PAWN)
+            return rowOf(target) == rowOf(x) - 1 && std::abs(colOf(target) - colOf(x)) == 1;
+
+        for (int d = 0; d < directionCount(type); d++) {
+            for (int square = step(x, SLIDER_STEPS[d]); square >= 0; square = step(square, SLIDER_STEPS[d])) {
+                if (square == target) return true;
+                if (square == blocker) break;
+            }
+        }
+        return false;
+    }
+
+    bool legal(PieceType type, int stm, int wk, int bk, int x) {
+        if (wk == bk || wk == x || bk == x || adjacent(wk, bk))
+            return false;
+        if (type == PieceType::PAWN && (rowOf(x) == 0 || rowOf(x) == 7))
+            return false;
+        // The side not to move must not be in check
+        return stm == 1 || !attacks(type, x, bk, wk);
+    }
+
+    // Published by the builder thread once complete, and never freed, so a
+    // probe during shutdown still finds valid memory
+    std::atomic<const Table*> tables[3];
+    std::atomic<bool> buildStarted{false};
+
+    int slotOf(PieceType type) {
+        return type == PieceType::QUEEN ? 0 : type == PieceType::ROOK ? 1 : 2;
+    }
+
+    // nullptr until built
+    const Table* table(PieceType type) {
+        return tables[slotOf(type)].load(std::memory_order_acquire);
+    }
+
+    // Calls onChild(index) for every legal move to a position in the same
+    // table and onExternal(value) for every move that leaves it: promotions
+    // (valued from the other table) and captures of the white piece (draws).
+    template <typename OnChild, typename OnExternal>
+    void forEachMove(PieceType type, int stm, int wk, int bk, int x, OnChild onChild, OnExternal onExternal) {
+        if (stm == 1) {
+            for (const auto& direction : KING_STEPS) {
+                int to = step(bk, direction);
+                if (to < 0 || adjacent(to, wk)) continue;
+                if (to == x) onExternal(0);
+                else if (!attacks(type, x, to, wk)) onChild(tableIndex(0, wk, to, x));
+            }
+            return;
+        }
+
+        for (const auto& direction : KING_STEPS) {
+            int to = step(wk, direction);
+            if (to < 0 || to == x || adjacent(to, bk)) continue;
+            onChild(tableIndex(1, to, bk, x));
+        }
+
+        if (type == PieceType::PAWN) {
+            int to = x - 8;
+            if (to == wk || to == bk) return;
+            if (rowOf(to) == 0) {
+                onExternal((*table(PieceType::QUEEN))[tableIndex(1, wk, bk, to)]);
+                onExternal((*table(PieceType::ROOK))[tableIndex(1, wk, bk, to)]);
+                onExternal(0);  // bishop or knight
+                return;
+            }
+            onChild(tableIndex(1, wk, bk, to));
+            if (rowOf(x) == 6 && to - 8 != wk && to - 8 != bk)
+                onChild(tableIndex(1, wk, bk, to - 8));
+            return;
+        }
+
+        for (int d = 0; d < directionCount(type); d++) {
+            for (int to = step(x, SLIDER_STEPS[d]); to >= 0 && to != wk && to != bk; to = step(to, SLIDER_STEPS[d])) {
+                onChild(tableIndex(1, wk, bk, to));
+            }
+        }
+    }
+
+    // The positions with a legal move to (stm, wk, bk, x), inside the table.
+    template <typename OnParent>
+    void forEachParent(PieceType type, int stm, int wk, int bk, int x, OnParent onParent) {
+        if (stm == 0) {
+            for (const auto& direction : KING_STEPS) {
+                int from = step(bk, direction);
+                if (from >= 0 && legal(type, 1, wk, from, x)) onParent(tableIndex(1, wk, from, x));
+            }
+            return;
+        }
+
+        for (const auto& direction : KING_STEPS) {
+            int from = step(wk, direction);
+            if (from >= 0 && legal(type, 0, from, bk, x)) onParent(tableIndex(0, from, bk, x));
+        }
+
+        if (type == PieceType::PAWN) {
+            int from = x + 8;
+            if (from == wk || from == bk) return;
+            if (legal(type, 0, wk, bk, from)) onParent(tableIndex(0, wk, bk, from));
+            if (rowOf(x) == 4 && from + 8 != wk && from + 8 != bk && legal(type, 0, wk, bk, from + 8))
+                onParent(tableIndex(0, wk, bk, from + 8));
+            return;
+        }
+
+        for (int d = 0; d < directionCount(type); d++) {
+            for (int from = step(x, SLIDER_STEPS[d]); from >= 0 && from != wk && from != bk; from = step(from, SLIDER_STEPS[d])) {
+                if (legal(type, 0, wk, bk, from)) onParent(tableIndex(0, wk, bk, from));
+            }
+        }
+    }
+
+    // Retrograde analysis in order of distance to mate. A position is won
+    // in n + 1 once any move reaches a position lost in n, and lost in n + 1
+    // once its last move is found to reach a position won in n. Whatever is
+    // left unresolved is a draw.
+    Table build(PieceType type) {
+        Table values(TABLE_SIZE, ILLEGAL);
+        std::vector<uint8_t> pending(TABLE_SIZE, 0);
+        std::vector<uint8_t> resolved(TABLE_SIZE, 0);
+
+        // Per distance: positions resolved at it, and moves out of the table
+        // to a position resolved at it
+        std::vector<std::vector<int>> done(1);
+        std::vector<std::vector<std::pair<int, int16_t>>> exits(1);
+        auto at = [](auto& buckets, size_t distance) -> auto& {
+            if (buckets.size() <= distance) buckets.resize(distance + 1);
+            return buckets[distance];
+        };
+
+        for (int stm = 0; stm < 2; stm++) {
+            for (int wk = 0; wk < 64; wk++) {
+                for (int bk = 0; bk < 64; bk++) {
+                    for (int x = 0; x < 64; x++) {
+                        if (!legal(type, stm, wk, bk, x)) continue;
+                        int index = tableIndex(stm, wk, bk, x);
+                        values[index] = 0;
+
+                        int moves = 0;
+                        forEachMove(type, stm, wk, bk, x,
+                            [&](int) { moves++; },
+                            [&](int16_t value) {
+                                moves++;
+                                if (value > 0) at(exits, value).emplace_back(index, value);
+                                else if (value < 0) at(exits, -value - 1).emplace_back(index, value);
+                            });
+                        pending[index] = (uint8_t)moves;
+
+                        if (moves == 0) {
+                            resolved[index] = 1;
+                            if (stm == 1 && attacks(type, x, bk, wk)) {
+                                values[index] = -1;     // checkmated
+                                done[0].push_back(index);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // The child's value is from the opponent's point of view
+        auto update = [&](int parent, int16_t childValue) {
+            if (resolved[parent]) return;
+            if (childValue < 0) {
+                int distance = -childValue;         // child mated in distance - 1
+                values[parent] = (int16_t)distance;
+                resolved[parent] = 1;
+                at(done, distance).push_back(parent);
+            } else if (--pending[parent] == 0) {
+                int distance = childValue + 1;
+                values[parent] = (int16_t)(-distance - 1);
+                resolved[parent] = 1;
+                at(done, distance).push_back(parent);
+            }
+        };
+
+        for (size_t distance = 0; distance < done.size() || distance < exits.size(); distance++) {
+            if (distance < exits.size()) {
+                for (const auto& [parent, value] : exits[distance]) update(parent, value);
+            }
+            for (size_t i = 0; distance < done.size() && i < done[distance].size(); i++) {
+                int index = done[distance][i];
+                int x = index % 64, bk = index / 64 % 64, wk = index / 4096 % 64, stm = index / 262144;
+                int16_t value = values[index];
+                forEachParent(type, stm, wk, bk, x, [&](int parent) { update(parent, value); });
+            }
+        }
+        return values;
+    }
+
+}
+
+void EndgameTables::prepare() {
+    if (buildStarted.exchange(true))
+        return;
+    std::thread([] {
+        // KPK promotes into the other two, so it is built last
+        for (PieceType type : { PieceType::QUEEN, PieceType::ROOK, PieceType::PAWN })
+            tables[slotOf(type)].store(new Table(build(type)), std::memory_order_release);
+    }).detach();
+}
+
+bool EndgameTables::ready() {
+    return table(PieceType::PAWN) != nullptr;
+}
+
+void EndgameTables::waitUntilReady() {
+    prepare();
+    while (!ready())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+bool EndgameTables::probe(const Board& board, Result& result) {
+    if (board.getPieceCount() > MAX_PIECES)
+        return false;
+
+    int kings[2] = { -1, -1 };
+    int pieceSquare = -1;
+    Piece* piece = nullptr;
+    int count = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* current = board.getPiece(row, col);
+            if (!current) continue;
+            if (++count > MAX_PIECES) return false;
+            if (current->getType() == PieceType::KING) {
+                kings[current->getColor() == PieceColor::WHITE ? 0 : 1] = row * 8 + col;
+            } else {
+                piece = current;
+                pieceSquare = row * 8 + col;
+            }
+        }
+    }
+    if (kings[0] < 0 || kings[1] < 0)
+        return false;
+
+    result = Result();
+    if (!piece || piece->getType() == PieceType::BISHOP || piece->getType() == PieceType::KNIGHT)
+        return true;
+
+    // Castling is not in the tables
+    PieceColor strong = piece->getColor();
+    int homeRow = strong == PieceColor::WHITE ? 7 : 0;
+    if (piece->getType() == PieceType::ROOK && !board.hasKingMoved(strong) && kings[strong == PieceColor::WHITE ? 0 : 1] == homeRow * 8 + 4 &&
+        ((pieceSquare == homeRow * 8 && !board.hasRookMoved(strong, false)) ||
+         (pieceSquare == homeRow * 8 + 7 && !board.hasRookMoved(strong, true)))) {
+        return false;
+    }
+
+    // Mirror vertically so the stronger side is white
+    int wk = kings[0], bk = kings[1], x = pieceSquare;
+    if (strong == PieceColor::BLACK) {
+        auto flip = [](int square) { return (7 - rowOf(square)) * 8 + colOf(square); };
+        wk = flip(kings[1]);
+        bk = flip(kings[0]);
+        x = flip(pieceSquare);
+    }
+    int stm = board.getCurrentTurn() == strong ? 0 : 1;
+
+    const Table* values = table(piece->getType());
+    if (!values) {
+        prepare();
+        return false;
+    }
+    int16_t value = (*values)[tableIndex(stm, wk, bk, x)];
+    if (value == ILLEGAL)
+        return false;
+    if (value > 0) {
+        result.outcome = Outcome::WIN;
+        result.plies = value;
+    } else if (value < 0) {
+        result.outcome = Outcome::LOSS;
+        result.plies = -value - 1;
+    }
+    return true;
+}
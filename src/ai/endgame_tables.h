@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../core/board.h"
+
+// Perfect play for positions with at most three pieces: KQK, KRK and KPK,
+// with KBK, KNK and bare kings drawn. Each table holds the distance to mate
+// of every position with the stronger side's piece, and is built by
+// retrograde analysis on a background thread, which takes a second or two.
+// The search never waits for it: until the tables are ready, probes of
+// positions that need them fail as if the tables did not cover them.
+//
+// No files are needed; larger endings come from Syzygy tablebase files
+// (see Syzygy), which the search probes after these. Boards with more than
+// MAX_PIECES pieces are turned away by their piece count before anything
+// else is looked at, so probing at every node of the search is cheap.
+namespace EndgameTables {
+    const int MAX_PIECES = 3;
+
+    enum class Outcome { LOSS = -1, DRAW = 0, WIN = 1 };
+
+    // For the side to move. plies counts half-moves until mate, 0 for a draw
+    // (and for a side that is already checkmated).
+    struct Result {
+        Outcome outcome = Outcome::DRAW;
+        int plies = 0;
+    };
+
+    // Starts building the tables in the background, once; probe() does so
+    // itself when it first needs them.
+    void prepare();
+    bool ready();
+    // Starts the build if needed and blocks until it is done
+    void waitUntilReady();
+
+    // False unless board has at most three pieces and the tables cover it
+    // (not, say, KRK with castling rights, or before they are built).
+    bool probe(const Board& board, Result& result);
+}
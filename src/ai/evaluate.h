@@ -1,5 +1,32 @@
 #pragma once
 #include "../core/board.h"
 
+// Every weight used by evaluate(). All members are ints so the struct can be
+// addressed as a flat array of EVAL_PARAM_COUNT weights (see evalParamData),
+// which is how the tuner reads and writes them.
+struct EvalParams {
+    int pieceValue[6];          // indexed by PieceType
+    int pst[6][8][8];           // piece-square tables from white's point of view
+    int knightRimPenalty;
+    int displacedKingPenalty;   // king off its start square while more than 20 pieces remain
+    int centerControlBonus;
+    int knightDevelopmentBonus;
+    int bishopDevelopmentBonus;
+    int isolatedPawnPenalty;
+    int uncastledKingPenalty;   // only while queens are on the board
+    int castledKingBonus;       // only while queens are on the board
+};
+
+constexpr int EVAL_PARAM_COUNT = sizeof(EvalParams) / sizeof(int);
+
+inline int* evalParamData(EvalParams& params) { return reinterpret_cast<int*>(&params); }
+inline const int* evalParamData(const EvalParams& params) { return reinterpret_cast<const int*>(&params); }
+
+extern const EvalParams defaultEvalParams;
+
 int evaluate(const Board& board);
+// Evaluates with an explicit weight set. When trace is non-null, every weight's
+// net white-minus-black coefficient is added to the matching slot of *trace, so
+// that the returned score equals the dot product of *trace and params.
+int evaluate(const Board& board, const EvalParams& params, EvalParams* trace);
 int evaluateIsolatedPawns(const Board& board, PieceColor color);
@@ -0,0 +1,248 @@
+#include "match.h"
+#include "endgame_tables.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+    // Normal quantile of the two-sided 95% interval
+    const double CONFIDENCE_Z = 1.96;
+
+    double eloFromScore(double score) {
+        score = std::min(std::max(score, 1e-4), 1.0 - 1e-4);
+        return 400.0 * std::log10(score / (1.0 - score));
+    }
+
+    double scoreFromElo(double elo) {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+}
+
+double MatchScore::score() const {
+    return games() ? (wins + 0.5 * draws) / games() : 0.5;
+}
+
+double MatchScore::elo() const {
+    return eloFromScore(score());
+}
+
+double MatchScore::eloError() const {
+    int n = games();
+    if (n == 0) return 0.0;
+    double p = score();
+    double variance = (wins * (1.0 - p) * (1.0 - p) + draws * (0.5 - p) * (0.5 - p) + losses * p * p) / n;
+    double margin = CONFIDENCE_Z * std::sqrt(variance / n);
+    return (eloFromScore(p + margin) - eloFromScore(p - margin)) / 2.0;
+}
+
+double MatchScore::llr(double elo0, double elo1) const {
+    int n = games();
+    if (n == 0) return 0.0;
+    double p = score();
+    double variance = (wins * (1.0 - p) * (1.0 - p) + draws * (0.5 - p) * (0.5 - p) + losses * p * p) / n;
+    if (variance <= 0.0) return 0.0;
+    double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+    return n * (s1 - s0) * (2.0 * p - s0 - s1) / (2.0 * variance);
+}
+
+double Match::sprtLowerBound(double alpha, double beta) {
+    return std::log(beta / (1.0 - alpha));
+}
+
+double Match::sprtUpperBound(double alpha, double beta) {
+    return std::log((1.0 - beta) / alpha);
+}
+
+void Match::configure(Bot& bot, const EngineConfig& config) {
+    bot.setHashSize(config.hashMB);
+    bot.setThreads(config.threads);
+    bot.setEvalParams(config.evalParams);
+    bot.setPruningMargins(config.pruningMargins);
+    bot.setEndgameTables(config.endgameTables);
+}
+
+Match::GameRecord Match::playGame(Bot* bots[2], int white, const std::string& openingFEN) {
+    Board board;
+    if (openingFEN.empty()) board.setupBoard();
+    else board.loadFEN(openingFEN);
+    board.resetPositionHistory();
+    bots[0]->newGame();
+    bots[1]->newGame();
+
+    const TimeControl& control = options.timeControl;
+    int64_t clock[2] = { control.baseMs, control.baseMs };     // indexed by colour
+    GameRecord record;
+
+    auto sideWins = [](PieceColor side) {
+        return side == PieceColor::WHITE ? Outcome::WHITE_WINS : Outcome::BLACK_WINS;
+    };
+
+    for (record.plies = 0;; record.plies++) {
+        PieceColor side = board.getCurrentTurn();
+        PieceColor opponent = side == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+
+        switch (board.getGameResult()) {
+            case GameResult::Checkmate:
+                record.outcome = sideWins(opponent);
+                record.reason = "checkmate";
+                return record;
+            case GameResult::Stalemate:
+                record.reason = "stalemate";
+                return record;
+            case GameResult::FiftyMoveRule:
+                record.reason = "fifty-move rule";
+                return record;
+            case GameResult::ThreefoldRepetition:
+                record.reason = "threefold repetition";
+                return record;
+            case GameResult::Ongoing:
+                break;
+        }
+
+        EndgameTables::Result table;
+        if (EndgameTables::probe(board, table)) {
+            if (table.outcome == EndgameTables::Outcome::WIN) record.outcome = sideWins(side);
+            else if (table.outcome == EndgameTables::Outcome::LOSS) record.outcome = sideWins(opponent);
+            record.reason = "endgame tables";
+            return record;
+        }
+        if (record.plies >= options.maxPlies) {
+            record.reason = "move limit";
+            return record;
+        }
+
+        int colorIndex = side == PieceColor::WHITE ? 0 : 1;
+        Bot& bot = *bots[colorIndex == 0 ? white : 1 - white];
+
+        SearchLimits limits;
+        if (control.nodes > 0) {
+            limits.nodes = control.nodes;
+        } else {
+            limits.whiteTime = (int)clock[0];
+            limits.blackTime = (int)clock[1];
+            limits.whiteIncrement = limits.blackIncrement = control.incrementMs;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Move move = bot.findBestMove(board, limits);
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        if (control.nodes == 0) {
+            clock[colorIndex] -= elapsed;
+            if (clock[colorIndex] < 0) {
+                record.outcome = sideWins(opponent);
+                record.reason = "loss on time";
+                record.timeLoss = true;
+                return record;
+            }
+            clock[colorIndex] += control.incrementMs;
+        }
+
+        if (!board.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion)) {
+            record.outcome = sideWins(opponent);
+            record.reason = "illegal move " + move.toString();
+            return record;
+        }
+    }
+}
+
+void Match::printReport(std::ostream& log, const MatchScore& score) const {
+    log << "Score of " << options.engines[0].name << " vs " << options.engines[1].name << ": "
+        << score.wins << " - " << score.losses << " - " << score.draws
+        << " [" << std::fixed << std::setprecision(3) << score.score() << "] " << score.games();
+    if (options.sprt.enabled) {
+        log << ", llr " << std::setprecision(2) << score.llr(options.sprt.elo0, options.sprt.elo1)
+            << " (" << sprtLowerBound(options.sprt.alpha, options.sprt.beta)
+            << ", " << sprtUpperBound(options.sprt.alpha, options.sprt.beta) << ")";
+    }
+    log << std::defaultfloat << std::endl;
+}
+
+MatchResult Match::run(std::ostream& log) {
+    int concurrency = options.concurrency > 0 ? options.concurrency
+                                              : (int)std::max(1u, std::thread::hardware_concurrency());
+    concurrency = std::max(1, std::min(concurrency, options.games));
+
+    MatchResult result;
+    std::atomic<int> nextGame{0};
+    std::mutex resultMutex;
+    int finished = 0;
+    const double lower = sprtLowerBound(options.sprt.alpha, options.sprt.beta);
+    const double upper = sprtUpperBound(options.sprt.alpha, options.sprt.beta);
+
+    // Adjudication and the engines' searches must not depend on how far the
+    // background build has got, or --nodes games would not be reproducible
+    EndgameTables::waitUntilReady();
+
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&] {
+        Bot first, second;
+        configure(first, options.engines[0]);
+        configure(second, options.engines[1]);
+        Bot* bots[2] = { &first, &second };
+
+        for (int game = nextGame++; game < options.games && !stopped; game = nextGame++) {
+            // Even games give the first engine white; the next game replays
+            // the opening with colours reversed.
+            int white = game % 2;
+            std::string opening;
+            if (!options.openings.empty()) opening = options.openings[(game / 2) % options.openings.size()];
+
+            GameRecord record;
+            try {
+                record = playGame(bots, white, opening);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                log << "Game " << game + 1 << " aborted: " << e.what() << std::endl;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            MatchScore& score = result.score;
+            if (record.outcome == Outcome::DRAW) score.draws++;
+            else if ((record.outcome == Outcome::WHITE_WINS) == (white == 0)) score.wins++;
+            else score.losses++;
+            if (record.timeLoss) score.timeLosses++;
+
+            finished++;
+            if (options.reportInterval > 0 && finished % options.reportInterval == 0) printReport(log, score);
+
+            if (options.sprt.enabled && result.sprt == SprtResult::NONE) {
+                double llr = score.llr(options.sprt.elo0, options.sprt.elo1);
+                if (llr >= upper) result.sprt = SprtResult::H1;
+                else if (llr <= lower) result.sprt = SprtResult::H0;
+                if (result.sprt != SprtResult::NONE) stopped = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < concurrency; i++) workers.emplace_back(worker);
+    for (auto& thread : workers) thread.join();
+
+    result.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    result.llr = result.score.llr(options.sprt.elo0, options.sprt.elo1);
+
+    const MatchScore& score = result.score;
+    printReport(log, score);
+    log << "Elo difference: " << std::fixed << std::setprecision(1) << score.elo()
+        << " +/- " << score.eloError() << " (95%)" << std::defaultfloat << std::endl;
+    if (score.timeLosses > 0) log << "Losses on time: " << score.timeLosses << std::endl;
+    if (options.sprt.enabled) {
+        log << "SPRT (" << std::setprecision(6) << options.sprt.elo0 << ", " << options.sprt.elo1 << "): ";
+        if (result.sprt == SprtResult::H1) log << "H1 accepted";
+        else if (result.sprt == SprtResult::H0) log << "H0 accepted";
+        else log << "inconclusive";
+        log << std::endl;
+    }
+    log << score.games() << " games in " << std::fixed << std::setprecision(1) << result.timeMs / 1000.0
+        << " s" << std::defaultfloat << std::endl;
+    return result;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "bot.h"
+#include "evaluate.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One side of a match: everything that can differ between the two bots.
+struct EngineConfig {
+    std::string name;
+    EvalParams evalParams = defaultEvalParams;
+    PruningMargins pruningMargins;
+    size_t hashMB = 16;
+    int threads = 1;
+    bool endgameTables = true;
+};
+
+// Per-move limits. With nodes set every move searches that many nodes,
+// which makes games reproducible and independent of machine load;
+// otherwise each side has a clock of baseMs plus incrementMs per move.
+struct TimeControl {
+    uint64_t nodes = 0;
+    int baseMs = 0;
+    int incrementMs = 0;
+};
+
+// Sequential probability ratio test of H0: elo = elo0 against H1: elo =
+// elo1, with error rates alpha and beta.
+struct SprtOptions {
+    bool enabled = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+struct MatchOptions {
+    EngineConfig engines[2];
+    TimeControl timeControl;
+    SprtOptions sprt;
+    int games = 100;
+    int concurrency = 0;        // games played at once, 0 = one per hardware thread
+    int maxPlies = 400;         // longer games are adjudicated as draws
+    std::vector<std::string> openings;  // FENs; empty plays from the start position
+    int reportInterval = 10;    // games between progress lines
+};
+
+// Wins, losses and draws from the first engine's point of view, and the
+// statistics derived from them.
+struct MatchScore {
+    int wins = 0;
+    int losses = 0;
+    int draws = 0;
+    int timeLosses = 0;         // games lost on time, by either engine
+
+    int games() const { return wins + losses + draws; }
+    double score() const;       // points per game, 0..1
+    // Elo difference with the half-width of its 95% confidence interval
+    double elo() const;
+    double eloError() const;
+    // Log-likelihood ratio of the SPRT hypotheses, using the normal
+    // approximation to the game score
+    double llr(double elo0, double elo1) const;
+};
+
+enum class SprtResult { NONE, H0, H1 };
+
+struct MatchResult {
+    MatchScore score;
+    SprtResult sprt = SprtResult::NONE;
+    double llr = 0.0;
+    int64_t timeMs = 0;
+};
+
+// Plays options.games games between the two engines, several at a time,
+// each worker keeping one Bot per engine. Games come in pairs that share an
+// opening with colours reversed, going through the openings in order. With
+// SPRT enabled, no new games start once the log-likelihood ratio crosses a
+// bound. Positions the endgame tables cover end the game with their result.
+class Match {
+public:
+    explicit Match(const MatchOptions& options) : options(options) {}
+
+    // Progress and the final report go to log
+    MatchResult run(std::ostream& log);
+
+    // Ends the match early; running games are finished
+    void stop() { stopped = true; }
+
+    static double sprtLowerBound(double alpha, double beta);
+    static double sprtUpperBound(double alpha, double beta);
+
+private:
+    enum class Outcome { WHITE_WINS, BLACK_WINS, DRAW };
+
+    struct GameRecord {
+        Outcome outcome = Outcome::DRAW;
+        std::string reason;
+        int plies = 0;
+        bool timeLoss = false;
+    };
+
+    GameRecord playGame(Bot* bots[2], int white, const std::string& openingFEN);
+    static void configure(Bot& bot, const EngineConfig& config);
+    void printReport(std::ostream& log, const MatchScore& score) const;
+
+    MatchOptions options;
+    std::atomic<bool> stopped{false};
+};
@@ -0,0 +1,410 @@
+#include "pgn.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool atLineStart(std::string_view text, size_t pos) {
+        return pos == 0 || text[pos - 1] == '\n';
+    }
+
+    // Position after the end of the line holding pos
+    size_t nextLine(std::string_view text, size_t pos) {
+        size_t end = text.find('\n', pos);
+        return end == std::string_view::npos ? text.size() : end + 1;
+    }
+
+    // Position after the '}' closing the comment that opens at pos
+    size_t skipComment(std::string_view text, size_t pos) {
+        size_t end = text.find('}', pos);
+        return end == std::string_view::npos ? text.size() : end + 1;
+    }
+
+    // Position after the ')' closing the variation that opens at pos;
+    // variations nest and may hold comments.
+    size_t skipVariation(std::string_view text, size_t pos) {
+        int depth = 0;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '{') {
+                pos = skipComment(text, pos);
+                continue;
+            }
+            if (c == ';') {
+                pos = nextLine(text, pos);
+                continue;
+            }
+            pos++;
+            if (c == '(') depth++;
+            else if (c == ')' && --depth == 0) break;
+        }
+        return pos;
+    }
+
+    // Parses the tag pair '[Name "value"]' starting at pos, returning the
+    // position after its line. tag is only set for a well-formed pair.
+    size_t parseTag(std::string_view text, size_t pos, PgnTag& tag, bool& valid) {
+        size_t end = nextLine(text, pos);
+        std::string_view line = text.substr(pos + 1, end - pos - 1);
+        valid = false;
+
+        size_t nameStart = 0;
+        while (nameStart < line.size() && isSpace(line[nameStart])) nameStart++;
+        size_t nameEnd = nameStart;
+        while (nameEnd < line.size() && !isSpace(line[nameEnd]) && line[nameEnd] != '"') nameEnd++;
+
+        size_t quote = line.find('"', nameEnd);
+        if (nameEnd == nameStart || quote == std::string_view::npos) return end;
+        size_t valueEnd = quote + 1;
+        while (valueEnd < line.size() && line[valueEnd] != '"') {
+            if (line[valueEnd] == '\\') valueEnd++;
+            valueEnd++;
+        }
+        if (valueEnd >= line.size()) return end;
+
+        tag.name = line.substr(nameStart, nameEnd - nameStart);
+        tag.value = line.substr(quote + 1, valueEnd - quote - 1);
+        valid = true;
+        return end;
+    }
+
+    // Movetext runs until the next tag line, outside comments
+    size_t movetextEnd(std::string_view text, size_t pos) {
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '{') pos = skipComment(text, pos);
+            else if (c == ';') pos = nextLine(text, pos);
+            else if (c == '[' && atLineStart(text, pos)) break;
+            else pos++;
+        }
+        return pos;
+    }
+
+    bool isResult(std::string_view token) {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+    PieceType pieceFromLetter(char letter) {
+        switch (letter) {
+            case 'N': return PieceType::KNIGHT;
+            case 'B': return PieceType::BISHOP;
+            case 'R': return PieceType::ROOK;
+            case 'Q': return PieceType::QUEEN;
+            case 'K': return PieceType::KING;
+            default: return PieceType::NONE;
+        }
+    }
+
+    // Sets board to the game's starting position. The board is reused from
+    // game to game, so even the standard start is loaded as a FEN to reset
+    // the side to move and castling rights.
+    bool setupGame(const PgnGame& game, Board& board) {
+        std::string_view fen = game.tag("FEN");
+        if (fen.empty()) {
+            board.loadFEN(START_FEN);
+        } else {
+            // The clock fields are optional in practice
+            std::string text(fen);
+            int fields = 0;
+            for (size_t i = 0; i < text.size(); i++) {
+                if (!isSpace(text[i]) && (i == 0 || isSpace(text[i - 1]))) fields++;
+            }
+            if (fields < 4) return false;
+            if (fields == 4) text += " 0 1";
+            else if (fields == 5) text += " 1";
+            try {
+                board.loadFEN(text);
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        board.resetPositionHistory();
+        return true;
+    }
+
+    // Plays the game's movetext on board, stopping at the result or the
+    // first move that cannot be played.
+    void replay(const PgnGame& game, const PgnCallbacks& callbacks, Board& board,
+                size_t& moves, std::string& error) {
+        std::string_view text = game.movetext;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (isSpace(c) || c == ')') {
+                pos++;
+                continue;
+            }
+            if (c == '{') {
+                pos = skipComment(text, pos);
+                continue;
+            }
+            if (c == ';' || (c == '%' && atLineStart(text, pos))) {
+                pos = nextLine(text, pos);
+                continue;
+            }
+            if (c == '(') {
+                pos = skipVariation(text, pos);
+                continue;
+            }
+            if (c == '$') {
+                for (pos++; pos < text.size() && isDigit(text[pos]); pos++) {}
+                continue;
+            }
+
+            size_t start = pos;
+            while (pos < text.size() && !isSpace(text[pos]) && !std::strchr("{}();", text[pos])) pos++;
+            std::string_view token = text.substr(start, pos - start);
+            if (isResult(token)) return;
+
+            // Move numbers, possibly run together with the move ("12.e4",
+            // "12...Nf6"). Castling may be written with zeros.
+            if (token.compare(0, 3, "0-0") != 0) {
+                size_t skip = 0;
+                while (skip < token.size() && isDigit(token[skip])) skip++;
+                while (skip < token.size() && token[skip] == '.') skip++;
+                token.remove_prefix(skip);
+                if (token.empty()) continue;
+            }
+
+            Move move;
+            if (!PgnReader::parseSAN(board, token, move)) {
+                error = "unknown move " + std::string(token);
+                return;
+            }
+            if (!board.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion)) {
+                error = "illegal move " + std::string(token);
+                return;
+            }
+            moves++;
+            if (callbacks.move) {
+                // A promoting pawn is gone by now
+                move.pieceMoved = board.getPiece(move.toRow, move.toCol);
+                callbacks.move(game, board, move);
+            }
+        }
+    }
+
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (const PgnTag& tag : tags) {
+        if (tag.name == name) return tag.value;
+    }
+    return std::string_view();
+}
+
+PgnReader::PgnReader(const std::string& path) {
+#ifdef __unix__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open PGN file: " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data = static_cast<const char*>(mapped);
+            mappedSize = length = info.st_size;
+            // The file is read front to back
+            madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+#endif
+
+    if (!data) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Cannot open PGN file: " + path);
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        length = buffer.size();
+    }
+}
+
+PgnReader::~PgnReader() {
+#ifdef __unix__
+    if (mappedSize)
+        munmap(const_cast<char*>(data), mappedSize);
+#endif
+}
+
+PgnSummary PgnReader::read(const PgnCallbacks& callbacks, int jobs) const {
+    std::string_view text(data, length);
+    jobs = std::max(1, jobs);
+    if (jobs == 1)
+        return parse(text, callbacks);
+
+    // Range boundaries move forward to the start of the next game
+    std::vector<size_t> bounds = { 0 };
+    for (int job = 1; job < jobs; job++) {
+        size_t at = std::max(length / jobs * job, bounds.back());
+        size_t game = text.find("\n[Event ", at);
+        bounds.push_back(game == std::string_view::npos ? length : game + 1);
+    }
+    bounds.push_back(length);
+
+    std::vector<PgnSummary> summaries(jobs);
+    std::vector<std::thread> workers;
+    for (int job = 0; job < jobs; job++) {
+        workers.emplace_back([&, job] {
+            size_t begin = bounds[job], end = bounds[job + 1];
+            summaries[job] = parse(text.substr(begin, end - begin), callbacks, begin);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    PgnSummary total;
+    for (const PgnSummary& summary : summaries) {
+        total.games += summary.games;
+        total.moves += summary.moves;
+        total.errors += summary.errors;
+    }
+    return total;
+}
+
+PgnSummary PgnReader::parse(std::string_view text, const PgnCallbacks& callbacks, size_t offset) {
+    PgnSummary summary;
+    PgnGame game;
+    Board board;
+    std::string error;
+
+    size_t pos = 0;
+    while (true) {
+        while (pos < text.size() && isSpace(text[pos])) pos++;
+        if (pos >= text.size()) break;
+
+        game.offset = offset + pos;
+        game.tags.clear();
+        while (pos < text.size() && text[pos] == '[') {
+            PgnTag tag;
+            bool valid;
+            pos = parseTag(text, pos, tag, valid);
+            if (valid) game.tags.push_back(tag);
+            while (pos < text.size() && isSpace(text[pos])) pos++;
+        }
+        size_t end = movetextEnd(text, pos);
+        game.movetext = text.substr(pos, end - pos);
+        pos = end;
+
+        summary.games++;
+        if (callbacks.game && !callbacks.game(game)) continue;
+        if (!callbacks.move && !callbacks.end) continue;
+
+        error.clear();
+        if (setupGame(game, board)) replay(game, callbacks, board, summary.moves, error);
+        else error = "invalid FEN";
+        if (!error.empty()) summary.errors++;
+        if (callbacks.end) callbacks.end(game, board, error);
+    }
+    return summary;
+}
+
+bool PgnReader::parseSAN(const Board& board, std::string_view san, Move& move) {
+    while (!san.empty() && std::strchr("+#!?", san.back())) san.remove_suffix(1);
+
+    PieceColor side = board.getCurrentTurn();
+    Piece* const (*grid)[8] = board.getBoard();
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int row = side == PieceColor::WHITE ? 7 : 0;
+        Piece* king = grid[row][4];
+        if (!king || king->getType() != PieceType::KING || king->getColor() != side) return false;
+        move = Move(row, 4, row, san.size() == 3 ? 6 : 2, king);
+        return true;
+    }
+
+    // Promotion suffix, "=Q" or just "Q"
+    PieceType promotion = PieceType::NONE;
+    if (san.size() >= 3 && pieceFromLetter(san.back()) != PieceType::NONE &&
+        (san[san.size() - 2] == '=' || isDigit(san[san.size() - 2]))) {
+        promotion = pieceFromLetter(san.back());
+        san.remove_suffix(san[san.size() - 2] == '=' ? 2 : 1);
+    }
+
+    PieceType type = PieceType::PAWN;
+    if (!san.empty() && pieceFromLetter(san[0]) != PieceType::NONE) {
+        type = pieceFromLetter(san[0]);
+        san.remove_prefix(1);
+    }
+    if (san.size() < 2) return false;
+
+    int toCol = san[san.size() - 2] - 'a';
+    int toRow = '8' - san[san.size() - 1];
+    if (toCol < 0 || toCol > 7 || toRow < 0 || toRow > 7) return false;
+    san.remove_suffix(2);
+
+    // What is left names the origin: file, rank or both, and 'x'
+    int fromCol = -1, fromRow = -1;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h') fromCol = c - 'a';
+        else if (c >= '1' && c <= '8') fromRow = '8' - c;
+        else if (c != 'x' && c != ':') return false;
+    }
+
+    if (type == PieceType::PAWN) {
+        // A pawn comes from the square behind its target, two squares
+        // behind for a double push, or diagonally behind for a capture.
+        int back = side == PieceColor::WHITE ? 1 : -1;
+        int col = fromCol >= 0 ? fromCol : toCol;
+        int row = toRow + back;
+        auto isOwnPawn = [&](int r) {
+            Piece* piece = r >= 0 && r < 8 ? grid[r][col] : nullptr;
+            return piece && piece->getType() == PieceType::PAWN && piece->getColor() == side;
+        };
+        if (col == toCol && !isOwnPawn(row) && row >= 0 && row < 8 && !grid[row][col]) row += back;
+        if (!isOwnPawn(row)) return false;
+        move = Move(row, col, toRow, toCol, grid[row][col], promotion);
+        return true;
+    }
+
+    // At most ten pieces of one kind can be on the board
+    Move candidates[10];
+    int count = 0;
+    for (int row = 0; row < 8; row++) {
+        if (fromRow >= 0 && row != fromRow) continue;
+        for (int col = 0; col < 8; col++) {
+            if (fromCol >= 0 && col != fromCol) continue;
+            Piece* piece = grid[row][col];
+            if (!piece || piece->getColor() != side || piece->getType() != type) continue;
+            if (!piece->isValidMove(row, col, toRow, toCol, const_cast<Piece* (*)[8]>(grid))) continue;
+            if (count < 10) candidates[count++] = Move(row, col, toRow, toCol, piece);
+        }
+    }
+
+    // SAN leaves out what a pinned piece makes unambiguous
+    if (count > 1) {
+        int legal = 0;
+        for (int i = 0; i < count; i++) {
+            const Move& candidate = candidates[i];
+            if (!board.isInCheckAfterMove(candidate.fromRow, candidate.fromCol, candidate.toRow, candidate.toCol, side))
+                candidates[legal++] = candidate;
+        }
+        count = legal;
+    }
+    if (count != 1) return false;
+    move = candidates[0];
+    return true;
+}
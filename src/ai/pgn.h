@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../core/board.h"
+#include "../core/move.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;     // without the quotes, escapes left as they are
+};
+
+// One game as it appears in the file. The views point into the reader's
+// buffer and stay valid as long as the reader does.
+struct PgnGame {
+    size_t offset = 0;          // byte offset of the game in the file
+    std::vector<PgnTag> tags;
+    std::string_view movetext;
+
+    // Value of the named tag, empty if the game has none
+    std::string_view tag(std::string_view name) const;
+};
+
+// Any of these may be left empty. When a file is read with several jobs
+// they are called from several threads at once, and games arrive out of
+// order (PgnGame::offset tells where each came from).
+struct PgnCallbacks {
+    // Called with each game before its moves are replayed. Returning false
+    // skips the replay, for callers that only want the tags.
+    std::function<bool(const PgnGame&)> game;
+    // Called for every move once it has been played, with the position
+    // after it; the move's piece is the one now on its target square.
+    // Moves that turn out illegal are reported to end instead.
+    std::function<void(const PgnGame&, const Board&, const Move&)> move;
+    // Called after the replay with the final position. error is empty, or
+    // says why the replay stopped early, in which case board is the position
+    // before the offending move.
+    std::function<void(const PgnGame&, const Board&, const std::string& error)> end;
+};
+
+struct PgnSummary {
+    size_t games = 0;
+    size_t moves = 0;
+    size_t errors = 0;          // games whose replay stopped early
+};
+
+// Streaming PGN reader. The file is memory-mapped (read into a buffer where
+// that fails) and parsed in place: tags and movetext are string views into
+// the mapping and SAN tokens are resolved without copying them. Comments,
+// variations, NAGs and move numbers are skipped; a game starting from a FEN
+// tag is replayed from that position.
+//
+// Reading with several jobs splits the file into ranges at "[Event " lines
+// and parses each range on its own thread.
+class PgnReader {
+public:
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit PgnReader(const std::string& path);
+    ~PgnReader();
+    PgnReader(const PgnReader&) = delete;
+    PgnReader& operator=(const PgnReader&) = delete;
+
+    size_t size() const { return length; }
+
+    PgnSummary read(const PgnCallbacks& callbacks, int jobs = 1) const;
+
+    // Parses PGN text that is not backed by a reader. offset is added to
+    // the games' offsets.
+    static PgnSummary parse(std::string_view text, const PgnCallbacks& callbacks, size_t offset = 0);
+
+    // Resolves a SAN move such as "Nbd7", "exd6", "O-O" or "e8=Q+" for the
+    // side to move: false if it fits no move or several. Pins are only
+    // looked at to tell apart pieces that could both go to the square, so
+    // whether the move found is legal is left to Board::movePiece.
+    static bool parseSAN(const Board& board, std::string_view san, Move& move);
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    size_t mappedSize = 0;
+    std::vector<char> buffer;   // used where the file cannot be mapped
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../core/board.h"
+#include "../core/move.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+// Read-only Polyglot opening book (.bin). The file is memory-mapped, so
+// every process using the same book shares one copy through the page cache,
+// and a lookup is a binary search over its 16-byte entries, which are sorted
+// by position key.
+//
+// Polyglot keys come from the fixed table of 781 random numbers published with
+// the format, which is built in; loadKeys() can replace it.
+class PolyglotBook {
+public:
+    // Throws std::runtime_error if the file cannot be opened or is not a
+    // Polyglot book.
+    explicit PolyglotBook(const std::string& path);
+    ~PolyglotBook();
+    PolyglotBook(const PolyglotBook&) = delete;
+    PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+    size_t size() const { return entryCount; }
+
+    // The legal book moves for board with their weights; empty when the
+    // position is not in the book.
+    std::vector<BookMove> probe(const Board& board) const;
+
+    // Picks one of probe()'s moves at random, each with probability
+    // proportional to its weight.
+    bool pickMove(const Board& board, std::mt19937_64& random, Move& move) const;
+
+    // Reads 781 keys from a text file, in order, as 0x-prefixed hex
+    // numbers with anything in between (the C array from the format
+    // description works as is). The table is checked against the known key
+    // of the start position. Throws std::runtime_error on failure.
+    static void loadKeys(const std::string& path);
+    static bool hasKeys();
+    static uint64_t key(const Board& board);
+
+private:
+    uint64_t keyAt(size_t index) const;
+
+    const unsigned char* entries = nullptr;
+    size_t entryCount = 0;
+    size_t mappedSize = 0;
+    std::vector<unsigned char> buffer;  // used where the file cannot be mapped
+};
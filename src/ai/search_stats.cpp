@@ -0,0 +1,75 @@
+#include "search_stats.h"
+#include <iomanip>
+#include <sstream>
+
+double SearchStats::firstMoveCutoffRate() const {
+    return betaCutoffs > 0 ? (double)cutoffsByMove[0] / betaCutoffs : 0.0;
+}
+
+double SearchStats::ttHitRate() const {
+    return ttProbes > 0 ? (double)ttHits / ttProbes : 0.0;
+}
+
+void SearchStats::add(const SearchStats& other) {
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    betaCutoffs += other.betaCutoffs;
+    for (int i = 0; i < CUTOFF_SLOTS; i++) cutoffsByMove[i] += other.cutoffsByMove[i];
+    nullMovePrunes += other.nullMovePrunes;
+    reverseFutilityPrunes += other.reverseFutilityPrunes;
+    razorPrunes += other.razorPrunes;
+    futilityPrunes += other.futilityPrunes;
+    seePrunes += other.seePrunes;
+    lmrReductions += other.lmrReductions;
+    lmrResearches += other.lmrResearches;
+    tableHits += other.tableHits;
+}
+
+void SearchStats::print(std::ostream& out) const {
+    // Formatted on the side so out keeps its own flags and precision
+    std::ostringstream rate;
+    rate << std::fixed << std::setprecision(1) << firstMoveCutoffRate() * 100;
+    out << "Nodes searched: " << totalNodes() << " (" << qnodes << " quiescence), TT hits: " << ttHits
+        << "/" << ttProbes << ", first-move cutoffs: " << rate.str() << "%" << std::endl;
+    out << "Pruned: null move " << nullMovePrunes << ", reverse futility " << reverseFutilityPrunes
+        << ", razoring " << razorPrunes << ", futility " << futilityPrunes << ", SEE " << seePrunes
+        << "; reduced " << lmrReductions << " (" << lmrResearches << " re-searched)" << std::endl;
+}
+
+void SearchStats::writeJSON(std::ostream& out) const {
+    out << "{\"depth\":" << depth
+        << ",\"threads\":" << threads
+        << ",\"timeMs\":" << timeMs
+        << ",\"nodes\":" << nodes
+        << ",\"qnodes\":" << qnodes
+        << ",\"nps\":" << (timeMs > 0 ? totalNodes() * 1000 / timeMs : 0)
+        << ",\"hashfull\":" << hashfull
+        << ",\"tt\":{\"probes\":" << ttProbes << ",\"hits\":" << ttHits << ",\"cutoffs\":" << ttCutoffs << "}"
+        << ",\"betaCutoffs\":" << betaCutoffs
+        << ",\"cutoffsByMove\":[";
+    for (int i = 0; i < CUTOFF_SLOTS; i++) out << (i ? "," : "") << cutoffsByMove[i];
+    out << "],\"firstMoveCutoffRate\":" << firstMoveCutoffRate()
+        << ",\"pruning\":{\"nullMove\":" << nullMovePrunes
+        << ",\"reverseFutility\":" << reverseFutilityPrunes
+        << ",\"razoring\":" << razorPrunes
+        << ",\"futility\":" << futilityPrunes
+        << ",\"see\":" << seePrunes << "}"
+        << ",\"reductions\":{\"lmr\":" << lmrReductions << ",\"researches\":" << lmrResearches << "}"
+        << ",\"tableHits\":" << tableHits
+        << ",\"iterations\":[";
+    for (size_t i = 0; i < iterations.size(); i++) {
+        const Iteration& iteration = iterations[i];
+        out << (i ? "," : "") << "{\"depth\":" << iteration.depth << ",\"nodes\":" << iteration.nodes
+            << ",\"timeMs\":" << iteration.timeMs << ",\"ebf\":" << iteration.branchingFactor << "}";
+    }
+    out << "]}";
+}
+
+std::string SearchStats::toJSON() const {
+    std::ostringstream out;
+    writeJSON(out);
+    return out.str();
+}
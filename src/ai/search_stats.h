@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Counters collected during one search, summed over all threads. Every
+// thread keeps its own copy while searching, so counting costs no
+// synchronisation.
+struct SearchStats {
+    // Beta cutoffs are counted by the index of the cutting move in the
+    // ordered move list; the last slot collects all later moves.
+    static const int CUTOFF_SLOTS = 8;
+
+    struct Iteration {
+        int depth = 0;
+        uint64_t nodes = 0;             // nodes spent in this iteration, all threads
+        int64_t timeMs = 0;             // elapsed at its end
+        double branchingFactor = 0.0;   // nodes relative to the previous iteration
+    };
+
+    uint64_t nodes = 0;                 // root and main search nodes
+    uint64_t qnodes = 0;                // quiescence nodes
+
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;                // an entry for the position was found
+    uint64_t ttCutoffs = 0;             // its score ended the node
+
+    uint64_t betaCutoffs = 0;           // main search only
+    uint64_t cutoffsByMove[CUTOFF_SLOTS] = {};
+
+    uint64_t nullMovePrunes = 0;
+    uint64_t reverseFutilityPrunes = 0;
+    uint64_t razorPrunes = 0;
+    uint64_t futilityPrunes = 0;
+    uint64_t seePrunes = 0;
+    uint64_t lmrReductions = 0;
+    uint64_t lmrResearches = 0;         // reduced searches that failed high
+    uint64_t tableHits = 0;             // nodes resolved by the endgame tables or Syzygy
+
+    // Filled in once the search has finished; taken from the main thread.
+    int depth = 0;                      // last completed iteration
+    int threads = 0;
+    int64_t timeMs = 0;
+    int hashfull = 0;                   // permille
+    std::vector<Iteration> iterations;
+
+    uint64_t totalNodes() const { return nodes + qnodes; }
+    double firstMoveCutoffRate() const;
+    double ttHitRate() const;
+
+    // Adds the counters of other; the per-search fields are left alone.
+    void add(const SearchStats& other);
+
+    void print(std::ostream& out) const;
+    void writeJSON(std::ostream& out) const;
+    std::string toJSON() const;
+};
@@ -0,0 +1,166 @@
+#include "see.h"
+#include "evaluate.h"
+#include <algorithm>
+
+namespace {
+
+    const int knightOffsets[8][2] = { {-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1} };
+    const int kingOffsets[8][2] = { {-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1} };
+    const int diagonals[4][2] = { {-1,-1}, {-1,1}, {1,-1}, {1,1} };
+    const int orthogonals[4][2] = { {-1,0}, {1,0}, {0,-1}, {0,1} };
+
+    uint64_t bit(int row, int col) { return 1ULL << (row * 8 + col); }
+    bool onBoard(int row, int col) { return row >= 0 && row < 8 && col >= 0 && col < 8; }
+
+    // Every piece in occupied that attacks (row, col), of either colour. The
+    // board array still holds captured pieces, so occupied decides which
+    // squares are taken; clearing a slider's bit exposes the piece behind it.
+    uint64_t attackersTo(const Board& board, int row, int col, uint64_t occupied) {
+        uint64_t attackers = 0;
+
+        auto addIf = [&](int r, int c, PieceType type) {
+            if (!onBoard(r, c) || !(occupied & bit(r, c))) return;
+            Piece* piece = board.getPiece(r, c);
+            if (piece && piece->getType() == type) attackers |= bit(r, c);
+        };
+
+        for (const auto& offset : knightOffsets) addIf(row + offset[0], col + offset[1], PieceType::KNIGHT);
+        for (const auto& offset : kingOffsets) addIf(row + offset[0], col + offset[1], PieceType::KING);
+
+        // White pawns capture towards row 0, black pawns towards row 7
+        for (int dc : { -1, 1 }) {
+            int r = row + 1, c = col + dc;
+            if (onBoard(r, c) && (occupied & bit(r, c))) {
+                Piece* piece = board.getPiece(r, c);
+                if (piece && piece->getType() == PieceType::PAWN && piece->getColor() == PieceColor::WHITE)
+                    attackers |= bit(r, c);
+            }
+            r = row - 1;
+            if (onBoard(r, c) && (occupied & bit(r, c))) {
+                Piece* piece = board.getPiece(r, c);
+                if (piece && piece->getType() == PieceType::PAWN && piece->getColor() == PieceColor::BLACK)
+                    attackers |= bit(r, c);
+            }
+        }
+
+        auto addSliders = [&](const int (*directions)[2], PieceType slider) {
+            for (int d = 0; d < 4; d++) {
+                int r = row + directions[d][0], c = col + directions[d][1];
+                while (onBoard(r, c) && !(occupied & bit(r, c))) {
+                    r += directions[d][0];
+                    c += directions[d][1];
+                }
+                if (!onBoard(r, c)) continue;
+                Piece* piece = board.getPiece(r, c);
+                if (piece && (piece->getType() == slider || piece->getType() == PieceType::QUEEN))
+                    attackers |= bit(r, c);
+            }
+        };
+        addSliders(diagonals, PieceType::BISHOP);
+        addSliders(orthogonals, PieceType::ROOK);
+
+        return attackers;
+    }
+
+    // Square of the least valuable piece of color in attackers, or -1.
+    int leastValuableAttacker(const Board& board, uint64_t attackers, PieceColor color) {
+        int best = -1, bestValue = 0;
+        while (attackers) {
+            int square = __builtin_ctzll(attackers);
+            attackers &= attackers - 1;
+            Piece* piece = board.getPiece(square / 8, square % 8);
+            if (piece->getColor() != color) continue;
+            int value = seePieceValue(piece->getType());
+            if (best < 0 || value < bestValue) {
+                best = square;
+                bestValue = value;
+            }
+        }
+        return best;
+    }
+
+}
+
+int seePieceValue(PieceType type) {
+    return defaultEvalParams.pieceValue[(int)type];
+}
+
+int staticExchange(const Board& board, const Move& move) {
+    Piece* moving = board.getPiece(move.fromRow, move.fromCol);
+    if (!moving) return 0;
+
+    Piece* target = board.getPiece(move.toRow, move.toCol);
+    uint64_t occupied = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            if (board.getPiece(row, col)) occupied |= bit(row, col);
+        }
+    }
+
+    int captured = target ? seePieceValue(target->getType()) : 0;
+    int onSquare = seePieceValue(moving->getType());
+
+    if (moving->getType() == PieceType::PAWN) {
+        // En passant: the captured pawn is beside the destination
+        if (!target && move.fromCol != move.toCol) {
+            captured = seePieceValue(PieceType::PAWN);
+            occupied &= ~bit(move.fromRow, move.toCol);
+        }
+        // Promotions are always to a queen
+        if (move.toRow == 0 || move.toRow == 7) {
+            captured += seePieceValue(PieceType::QUEEN) - seePieceValue(PieceType::PAWN);
+            onSquare = seePieceValue(PieceType::QUEEN);
+        }
+    }
+
+    // gain[d] is the balance for the side that made capture d, assuming the
+    // exchange stops after it.
+    int gain[32];
+    int d = 0;
+    gain[0] = captured;
+    occupied &= ~bit(move.fromRow, move.fromCol);
+    occupied |= bit(move.toRow, move.toCol);
+    PieceColor side = moving->getColor() == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+
+    while (d < 31) {
+        uint64_t attackers = attackersTo(board, move.toRow, move.toCol, occupied) & occupied;
+        attackers &= ~bit(move.toRow, move.toCol);
+        int square = leastValuableAttacker(board, attackers, side);
+        if (square < 0) break;
+
+        PieceType type = board.getPiece(square / 8, square % 8)->getType();
+        PieceColor other = side == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+
+        // The king may only recapture when nothing can take it back
+        if (type == PieceType::KING &&
+            leastValuableAttacker(board, attackers & ~(1ULL << square), other) >= 0)
+            break;
+
+        d++;
+        gain[d] = onSquare - gain[d - 1];
+
+        onSquare = seePieceValue(type);
+        occupied &= ~(1ULL << square);
+        side = other;
+    }
+
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+bool staticExchangeAtLeast(const Board& board, const Move& move, int threshold) {
+    Piece* moving = board.getPiece(move.fromRow, move.fromCol);
+    Piece* target = board.getPiece(move.toRow, move.toCol);
+
+    // Taking something at least as valuable as the capturing piece wins
+    // that much even if the capturer is lost, so the exchange need not be
+    // played out.
+    if (moving && target && moving->getType() != PieceType::PAWN &&
+        seePieceValue(target->getType()) - seePieceValue(moving->getType()) >= threshold)
+        return true;
+
+    return staticExchange(board, move) >= threshold;
+}
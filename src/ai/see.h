@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../core/board.h"
+#include "../core/move.h"
+
+// Static exchange evaluation: the material the side to move gains by playing
+// move and then letting both sides recapture on the destination square with
+// their least valuable attacker, each free to stop when recapturing would
+// lose. Attackers hidden behind a capturing slider (x-rays) join in once the
+// slider has moved. Pins and checks are ignored.
+//
+// Also works for quiet moves, where it tells whether the moved piece can be
+// won on its new square.
+int staticExchange(const Board& board, const Move& move);
+
+// staticExchange(board, move) >= threshold, but usually cheaper.
+bool staticExchangeAtLeast(const Board& board, const Move& move, int threshold);
+
+int seePieceValue(PieceType type);
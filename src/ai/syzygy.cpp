@@ -0,0 +1,955 @@
+#include "syzygy.h"
+#include "../core/move_generator.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The file format follows the tables' generator. Squares are numbered from
+// a1 = 0 to h8 = 63; ^ 7 mirrors a square left to right and ^ 56 top to
+// bottom. Piece codes are 1-6 for a white pawn, knight, bishop, rook, queen
+// and king and 9-14 for black, so ^ 8 swaps the colour.
+//
+// A table stores each position once, under an index built from its pieces
+// in a fixed order after mirroring it into a canonical corner, and the
+// values are compressed by recursive pairing: symbols stand for pairs of
+// symbols, and the symbols are Huffman coded in blocks.
+namespace {
+    using Syzygy::MAX_PIECES;
+
+    enum class Kind { WDL, DTZ };
+
+    // Flags of a table's header byte, and of each of its value streams
+    const int SPLIT = 1, HAS_PAWNS = 2;
+    const int STM = 1, MAPPED = 2, WIN_PLIES = 4, LOSS_PLIES = 8, WIDE = 16, SINGLE_VALUE = 128;
+
+    int rankOf(int square) { return square >> 3; }
+    int fileOf(int square) { return square & 7; }
+    // Negative below the a1-h8 diagonal, 0 on it
+    int offDiagonal(int square) { return rankOf(square) - fileOf(square); }
+
+    uint32_t readLE16(const uint8_t* p) { return p[0] | p[1] << 8; }
+    uint32_t readLE32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+    uint32_t readBE32(const uint8_t* p) { return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+    uint64_t readBE64(const uint8_t* p) { return (uint64_t)readBE32(p) << 32 | readBE32(p + 4); }
+
+    // Tables turning piece placements into indices
+    struct IndexMaps {
+        int pawns[64] = {};             // a2-h7 to 0-47, edge files and low ranks highest
+        int b1h1h7[64] = {};            // squares below the diagonal to 0-27
+        int a1d1d4[64] = {};            // the a1-d1-d4 triangle to 0-9, diagonal last
+        int kings[10][64] = {};         // both kings, the first in the triangle, to 0-461
+        int binomial[7][64] = {};       // [k][n]: ways to choose k of n
+        int leadPawn[7][64] = {};       // first index for the leading pawn's square
+        int leadPawnsSize[7][4] = {};   // [leading pawns][file]
+
+        IndexMaps() {
+            int code = 0;
+            for (int s = 0; s < 64; s++)
+                if (offDiagonal(s) < 0) b1h1h7[s] = code++;
+
+            std::vector<int> diagonal;
+            code = 0;
+            for (int s = 0; s <= 27; s++) {     // a1 to d4
+                if (offDiagonal(s) < 0 && fileOf(s) <= 3) a1d1d4[s] = code++;
+                else if (!offDiagonal(s) && fileOf(s) <= 3) diagonal.push_back(s);
+            }
+            for (int s : diagonal) a1d1d4[s] = code++;
+
+            // With the first king on the diagonal the second stays on or
+            // below it; placements with both on it come last
+            std::vector<std::pair<int, int>> bothOnDiagonal;
+            code = 0;
+            for (int index = 0; index < 10; index++) {
+                for (int s1 = 0; s1 <= 27; s1++) {
+                    if (a1d1d4[s1] != index || (!index && s1 != 1)) continue;     // b1 is 0
+                    for (int s2 = 0; s2 < 64; s2++) {
+                        if (std::abs(rankOf(s1) - rankOf(s2)) <= 1 && std::abs(fileOf(s1) - fileOf(s2)) <= 1)
+                            continue;
+                        if (!offDiagonal(s1) && offDiagonal(s2) > 0) continue;
+                        if (!offDiagonal(s1) && !offDiagonal(s2)) bothOnDiagonal.emplace_back(index, s2);
+                        else kings[index][s2] = code++;
+                    }
+                }
+            }
+            for (const auto& [index, s2] : bothOnDiagonal) kings[index][s2] = code++;
+
+            binomial[0][0] = 1;
+            for (int n = 1; n < 64; n++)
+                for (int k = 0; k < 7 && k <= n; k++)
+                    binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+
+            // The leading pawn is the one nearest an edge and, on its file,
+            // lowest; the others can only stand on squares it ranks above.
+            int available = 47;
+            for (int count = 1; count <= 5; count++) {
+                for (int file = 0; file < 4; file++) {
+                    int index = 0;
+                    for (int rank = 1; rank <= 6; rank++) {
+                        int s = rank * 8 + file;
+                        if (count == 1) {
+                            pawns[s] = available--;
+                            pawns[s ^ 7] = available--;
+                        }
+                        leadPawn[count][s] = index;
+                        index += binomial[count - 1][pawns[s]];
+                    }
+                    leadPawnsSize[count][file] = index;
+                }
+            }
+        }
+    };
+
+    const IndexMaps maps;
+
+    bool pawnOrder(int a, int b) { return maps.pawns[a] < maps.pawns[b]; }
+
+    // One compressed stream of values: per side to move and, with pawns,
+    // per file of the leading pawn
+    struct PairsData {
+        uint8_t flags = 0;
+        size_t blockSize = 0;
+        size_t span = 0;                        // values between sparse index entries
+        uint32_t blockCount = 0;
+        int maxSymbolLength = 0;
+        int minSymbolLength = 0;                // the value itself for SINGLE_VALUE
+        const uint8_t* lowestSymbol = nullptr;  // per code length, 16 bits
+        const uint8_t* pairs = nullptr;         // per symbol, the two it stands for in 12 bits each
+        const uint8_t* blockLength = nullptr;   // values per block minus one, 16 bits
+        size_t blockLengthCount = 0;
+        const uint8_t* sparseIndex = nullptr;   // 32-bit block and 16-bit offset per span
+        size_t sparseIndexCount = 0;
+        const uint8_t* data = nullptr;
+        std::vector<uint64_t> base64;           // lowest code of each length, left-aligned
+        std::vector<uint8_t> symbolLength;      // values a symbol expands to, minus one
+        int pieces[MAX_PIECES] = {};            // the order pieces are encoded in
+        uint64_t groupIndex[MAX_PIECES + 1] = {};
+        int groupLength[MAX_PIECES + 1] = {};   // zero-terminated
+        uint32_t mapIndex[4] = {};              // DTZ value maps for win, loss, cursed win, blessed loss
+
+        int left(int symbol) const {
+            const uint8_t* p = pairs + 3 * symbol;
+            return (p[1] & 0xF) << 8 | p[0];
+        }
+        int right(int symbol) const {
+            const uint8_t* p = pairs + 3 * symbol;
+            return p[2] << 4 | p[1] >> 4;
+        }
+    };
+
+    // A table file, memory-mapped where the platform allows, else read
+    struct TableFile {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> buffer;
+        bool mapped = false;
+
+        ~TableFile() {
+#ifdef __unix__
+            if (mapped) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        }
+
+        bool open(const std::string& path, Kind kind) {
+#ifdef __unix__
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0) {
+                void* base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (base != MAP_FAILED) {
+                    data = static_cast<const uint8_t*>(base);
+                    size = info.st_size;
+                    mapped = true;
+                }
+            }
+            close(fd);
+#endif
+            if (!data) {
+                std::ifstream file(path, std::ios::binary);
+                if (!file)
+                    return false;
+                buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                data = buffer.data();
+                size = buffer.size();
+            }
+
+            static const uint8_t MAGIC[2][4] = { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } };
+            return size % 64 == 16 && std::memcmp(data, MAGIC[kind == Kind::DTZ], 4) == 0;
+        }
+    };
+
+    struct Table {
+        Kind kind = Kind::WDL;
+        std::string path;
+        uint32_t key = 0;           // material of the name as written ("KRvK": white has the rook)
+        uint32_t key2 = 0;          // the same with colours swapped
+        int pieceCount = 0;
+        bool hasPawns = false;
+        bool hasUniquePieces = false;
+        int pawnCount[2] = {};      // leading colour first
+
+        std::atomic<bool> ready{false};
+        bool loaded = false;        // set with ready: file found and valid
+        TableFile file;
+        const uint8_t* dtzMap = nullptr;
+        PairsData items[2][4];      // [side to move][file]; DTZ tables hold one side
+
+        PairsData* get(int stm, int file) {
+            return &items[kind == Kind::WDL ? stm : 0][hasPawns ? file : 0];
+        }
+    };
+
+    struct Entry {
+        Table wdl, dtz;
+    };
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::unordered_map<uint32_t, Entry*> entriesByKey;
+    int largestTable = 0;
+    std::mutex loadMutex;
+
+    // 3 bits per piece type and colour (at most 5 of a kind in 7 pieces),
+    // kings left out
+    uint32_t materialBit(int code) {
+        return 1u << (3 * ((code & 7) - 1) + (code & 8 ? 15 : 0));
+    }
+
+    uint32_t swapColours(uint32_t key) {
+        return key >> 15 | (key & 0x7FFF) << 15;
+    }
+
+    // Fills in the material of a table from its name, e.g. "KRPvKR"
+    bool describe(const std::string& name, Table& table) {
+        static const std::string CODES = " PNBRQK";
+        size_t split = name.find('v');
+        if (split == std::string::npos || name[0] != 'K' || split + 1 >= name.size() || name[split + 1] != 'K')
+            return false;
+
+        int count[2][7] = {};
+        for (size_t i = 0; i < name.size(); i++) {
+            if (i == split) continue;
+            size_t code = CODES.find(name[i]);
+            if (code == std::string::npos || code == 0) return false;
+            count[i > split][code]++;
+            table.pieceCount++;
+            if (code != 6) table.key += materialBit((int)code + (i > split ? 8 : 0));
+        }
+        if (count[0][6] != 1 || count[1][6] != 1 || table.pieceCount > MAX_PIECES)
+            return false;
+
+        table.key2 = swapColours(table.key);
+        table.hasPawns = count[0][1] || count[1][1];
+        for (int side = 0; side < 2; side++)
+            for (int code = 1; code < 6; code++)
+                if (count[side][code] == 1) table.hasUniquePieces = true;
+
+        // The side with fewer pawns leads, when both have some
+        bool whiteLeads = !count[1][1] || (count[0][1] && count[1][1] >= count[0][1]);
+        table.pawnCount[0] = count[whiteLeads ? 0 : 1][1];
+        table.pawnCount[1] = count[whiteLeads ? 1 : 0][1];
+        return true;
+    }
+
+    // Works out how the pieces of one stream are grouped and what each
+    // group's index is multiplied by. order gives the position of the
+    // leading group and of the other side's pawns among the groups.
+    void setGroups(const Table& table, PairsData* d, const int order[2], int file) {
+        int n = 0, firstLength = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+        d->groupLength[n] = 1;
+        for (int i = 1; i < table.pieceCount; i++) {
+            if (--firstLength > 0 || d->pieces[i] == d->pieces[i - 1]) d->groupLength[n]++;
+            else d->groupLength[++n] = 1;
+        }
+        d->groupLength[++n] = 0;
+
+        bool bothPawns = table.hasPawns && table.pawnCount[1];
+        int next = bothPawns ? 2 : 1;
+        int freeSquares = 64 - d->groupLength[0] - (bothPawns ? d->groupLength[1] : 0);
+        uint64_t index = 1;
+        for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+            if (k == order[0]) {
+                d->groupIndex[0] = index;
+                index *= table.hasPawns ? maps.leadPawnsSize[d->groupLength[0]][file]
+                       : table.hasUniquePieces ? 31332 : 462;
+            } else if (k == order[1]) {
+                d->groupIndex[1] = index;
+                index *= maps.binomial[d->groupLength[1]][48 - d->groupLength[0]];
+            } else {
+                d->groupIndex[next] = index;
+                index *= maps.binomial[d->groupLength[next]][freeSquares];
+                freeSquares -= d->groupLength[next++];
+            }
+        }
+        d->groupIndex[n] = index;
+    }
+
+    // Length of what symbol expands to, minus one, filling in its halves
+    // first. Leaves have 0xFFF as their right half.
+    uint8_t symbolLength(PairsData* d, int symbol, std::vector<bool>& visited) {
+        visited[symbol] = true;
+        int right = d->right(symbol);
+        if (right == 0xFFF)
+            return 0;
+        int left = d->left(symbol);
+        if (left >= (int)visited.size() || right >= (int)visited.size())
+            return 0;
+        if (!visited[left]) d->symbolLength[left] = symbolLength(d, left, visited);
+        if (!visited[right]) d->symbolLength[right] = symbolLength(d, right, visited);
+        return d->symbolLength[left] + d->symbolLength[right] + 1;
+    }
+
+    // Reads a stream's block and Huffman code sizes; nullptr past end
+    const uint8_t* setSizes(PairsData* d, const uint8_t* data, const uint8_t* end) {
+        if (data + 2 > end)
+            return nullptr;
+        d->flags = *data++;
+        if (d->flags & SINGLE_VALUE) {
+            d->span = 1;
+            d->minSymbolLength = *data++;
+            return data;
+        }
+
+        if (data + 10 > end)
+            return nullptr;
+        uint64_t size = d->groupIndex[std::find(d->groupLength, d->groupLength + MAX_PIECES, 0) - d->groupLength];
+        d->blockSize = size_t(1) << *data++;
+        d->span = size_t(1) << *data++;
+        d->sparseIndexCount = (size + d->span - 1) / d->span;
+        int padding = *data++;
+        d->blockCount = readLE32(data);
+        data += 4;
+        d->blockLengthCount = d->blockCount + padding;
+        d->maxSymbolLength = *data++;
+        d->minSymbolLength = *data++;
+        if (d->minSymbolLength < 1 || d->maxSymbolLength < d->minSymbolLength || d->maxSymbolLength > 32)
+            return nullptr;
+        d->lowestSymbol = data;
+
+        // Canonical Huffman codes: longer codes have lower values, so each
+        // length's lowest code, left-aligned in 64 bits, is below the last
+        // length's, and a code's length is found by comparing against them
+        d->base64.assign(d->maxSymbolLength - d->minSymbolLength + 1, 0);
+        if (data + 2 * d->base64.size() + 2 > end)
+            return nullptr;
+        for (int i = (int)d->base64.size() - 2; i >= 0; i--) {
+            d->base64[i] = (d->base64[i + 1] + readLE16(d->lowestSymbol + 2 * i)
+                            - readLE16(d->lowestSymbol + 2 * (i + 1))) / 2;
+        }
+        for (size_t i = 0; i < d->base64.size(); i++)
+            d->base64[i] <<= 64 - i - d->minSymbolLength;
+        data += 2 * d->base64.size();
+
+        size_t symbols = readLE16(data);
+        data += 2;
+        if (data + 3 * symbols > end)
+            return nullptr;
+        d->pairs = data;
+        d->symbolLength.assign(symbols, 0);
+        std::vector<bool> visited(symbols);
+        for (size_t symbol = 0; symbol < symbols; symbol++) {
+            if (!visited[symbol]) d->symbolLength[symbol] = symbolLength(d, (int)symbol, visited);
+        }
+        return data + 3 * symbols + (symbols & 1);
+    }
+
+    // DTZ values may be stored as indices into per-result value lists
+    const uint8_t* setDTZMap(Table& table, const uint8_t* data, const uint8_t* end, int files) {
+        const uint8_t* base = table.file.data;
+        table.dtzMap = data;
+        for (int file = 0; file < files; file++) {
+            PairsData* d = table.get(0, file);
+            if (!(d->flags & MAPPED)) continue;
+            for (int i = 0; i < 4; i++) {
+                if (d->flags & WIDE) {
+                    data += (data - base) & 1;
+                    if (data + 2 > end) return nullptr;
+                    d->mapIndex[i] = (uint32_t)((data - table.dtzMap) / 2 + 1);
+                    data += 2 * readLE16(data) + 2;
+                } else {
+                    if (data >= end) return nullptr;
+                    d->mapIndex[i] = (uint32_t)(data - table.dtzMap + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        return data + ((data - base) & 1);
+    }
+
+    // Lays the streams out over the file after the magic number. False if
+    // it does not match the table's material or is shorter than it says.
+    bool parse(Table& table) {
+        const uint8_t* base = table.file.data;
+        const uint8_t* end = base + table.file.size;
+        const uint8_t* data = base + 4;
+        auto align = [&](const uint8_t* p, size_t to) { return base + ((p - base + to - 1) & ~(to - 1)); };
+
+        bool split = table.key != table.key2;
+        if (bool(*data & HAS_PAWNS) != table.hasPawns || bool(*data & SPLIT) != split)
+            return false;
+        data++;
+
+        int sides = table.kind == Kind::WDL && split ? 2 : 1;
+        int files = table.hasPawns ? 4 : 1;
+        bool bothPawns = table.hasPawns && table.pawnCount[1];
+        for (int file = 0; file < files; file++) {
+            if (data + 1 + bothPawns + table.pieceCount > end)
+                return false;
+            int order[2][2] = { { data[0] & 0xF, bothPawns ? data[1] & 0xF : 0xF },
+                                { data[0] >> 4, bothPawns ? data[1] >> 4 : 0xF } };
+            data += 1 + bothPawns;
+            for (int k = 0; k < table.pieceCount; k++, data++) {
+                for (int i = 0; i < sides; i++)
+                    table.get(i, file)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+            }
+            for (int i = 0; i < sides; i++)
+                setGroups(table, table.get(i, file), order[i], file);
+        }
+        data = align(data, 2);
+
+        for (int file = 0; file < files; file++) {
+            for (int i = 0; i < sides && data; i++)
+                data = setSizes(table.get(i, file), data, end);
+        }
+        if (data && table.kind == Kind::DTZ)
+            data = setDTZMap(table, data, end, files);
+        if (!data)
+            return false;
+
+        for (int file = 0; file < files; file++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = table.get(i, file);
+                d->sparseIndex = data;
+                data += 6 * d->sparseIndexCount;
+            }
+        }
+        for (int file = 0; file < files; file++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = table.get(i, file);
+                d->blockLength = data;
+                data += 2 * d->blockLengthCount;
+            }
+        }
+        for (int file = 0; file < files; file++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = table.get(i, file);
+                data = align(data, 64);
+                d->data = data;
+                data += (size_t)d->blockCount * d->blockSize;
+            }
+        }
+        return data <= end;
+    }
+
+    // Maps and parses the file on first use. Only the first caller does
+    // the work; the rest see ready and whether it worked.
+    bool load(Table& table) {
+        if (table.ready.load(std::memory_order_acquire))
+            return table.loaded;
+        std::lock_guard<std::mutex> lock(loadMutex);
+        if (!table.ready.load(std::memory_order_relaxed)) {
+            table.loaded = !table.path.empty() && table.file.open(table.path, table.kind) && parse(table);
+            table.ready.store(true, std::memory_order_release);
+        }
+        return table.loaded;
+    }
+
+    // The value at index: find its block through the sparse index, then
+    // decode symbols until the one covering it, and expand that.
+    int decompress(const PairsData* d, uint64_t index) {
+        if (d->flags & SINGLE_VALUE)
+            return d->minSymbolLength;
+
+        // Sparse entry k points at the value with index k * span + span / 2
+        uint32_t k = uint32_t(index / d->span);
+        uint32_t block = readLE32(d->sparseIndex + 6 * k);
+        int offset = (int)readLE16(d->sparseIndex + 6 * k + 4);
+        offset += int(index % d->span) - int(d->span / 2);
+
+        while (offset < 0)
+            offset += readLE16(d->blockLength + 2 * --block) + 1;
+        while (offset > (int)readLE16(d->blockLength + 2 * block))
+            offset -= readLE16(d->blockLength + 2 * block++) + 1;
+
+        const uint8_t* p = d->data + (uint64_t)block * d->blockSize;
+        uint64_t buffer = readBE64(p);
+        p += 8;
+        int bits = 64;
+        int symbol;
+        while (true) {
+            int length = 0;
+            while (buffer < d->base64[length])
+                length++;
+            symbol = int((buffer - d->base64[length]) >> (64 - length - d->minSymbolLength));
+            symbol += readLE16(d->lowestSymbol + 2 * length);
+            if (offset < d->symbolLength[symbol] + 1)
+                break;
+            offset -= d->symbolLength[symbol] + 1;
+            length += d->minSymbolLength;
+            buffer <<= length;
+            bits -= length;
+            if (bits <= 32) {
+                bits += 32;
+                buffer |= (uint64_t)readBE32(p) << (64 - bits);
+                p += 4;
+            }
+        }
+
+        // A pair's halves stand for adjacent runs of values
+        while (d->symbolLength[symbol]) {
+            int left = d->left(symbol);
+            if (offset < d->symbolLength[left] + 1) {
+                symbol = left;
+            } else {
+                offset -= d->symbolLength[left] + 1;
+                symbol = d->right(symbol);
+            }
+        }
+        return d->left(symbol);
+    }
+
+    // A board in the tables' terms
+    struct Position {
+        int pieces[64] = {};        // piece codes, 0 for empty
+        int sideToMove = 0;         // 0 white, 1 black
+        int pieceCount = 0;
+        uint32_t key = 0;
+
+        explicit Position(const Board& board) {
+            static const int CODES[] = { 1, 4, 2, 3, 5, 6 };    // PieceType order
+            for (int row = 0; row < 8; row++) {
+                for (int col = 0; col < 8; col++) {
+                    const Piece* piece = board.getPiece(row, col);
+                    if (!piece) continue;
+                    int code = CODES[(int)piece->getType()] + (piece->isWhite() ? 0 : 8);
+                    pieces[(7 - row) * 8 + col] = code;
+                    pieceCount++;
+                    if ((code & 7) != 6) key += materialBit(code);
+                }
+            }
+            sideToMove = board.getCurrentTurn() == PieceColor::WHITE ? 0 : 1;
+        }
+    };
+
+    enum class State { FAIL, OK, CHANGE_SIDE, ZEROING_BEST_MOVE };
+
+    const int WDL_LOSS = -2, WDL_BLESSED_LOSS = -1, WDL_DRAW = 0, WDL_CURSED_WIN = 1, WDL_WIN = 2;
+
+    int sign(int value) { return (value > 0) - (value < 0); }
+
+    // DTZ values are stored in moves unless the flags say plies, and for
+    // some results through a map
+    int mapDTZ(Table& table, int file, int value, int wdl) {
+        static const int MAP_FOR[] = { 1, 3, 0, 2, 0 };     // by wdl + 2
+        const PairsData* d = table.get(0, file);
+        if (d->flags & MAPPED) {
+            size_t i = d->mapIndex[MAP_FOR[wdl + 2]] + value;
+            value = d->flags & WIDE ? (int)readLE16(table.dtzMap + 2 * i) : table.dtzMap[i];
+        }
+        if ((wdl == WDL_WIN && !(d->flags & WIN_PLIES)) || (wdl == WDL_LOSS && !(d->flags & LOSS_PLIES)) ||
+            wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS) {
+            value *= 2;
+        }
+        return value + 1;
+    }
+
+    // Where pos is stored in table: the stream and its index there. False
+    // when a DTZ table only holds the other side to move.
+    bool locate(Table& table, const Position& pos, PairsData*& d, int& file, uint64_t& index) {
+        // Tables hold the side named first as white, and symmetric ones only
+        // white to move: otherwise swap the colours and mirror the board.
+        bool flip = pos.key != table.key || (table.key == table.key2 && pos.sideToMove == 1);
+        int flipColour = flip ? 8 : 0, flipSquares = flip ? 56 : 0;
+        int stm = (flip ? 1 : 0) ^ pos.sideToMove;
+
+        int squares[MAX_PIECES], pieces[MAX_PIECES];
+        int size = 0, leadPawnCount = 0;
+        file = 0;
+        uint64_t leadPawns = 0;
+
+        // With pawns there is a table per file of the leading pawn, a-d
+        if (table.hasPawns) {
+            int leadPawn = table.get(0, 0)->pieces[0] ^ flipColour;
+            for (int s = 0; s < 64; s++) {
+                if (pos.pieces[s] != leadPawn) continue;
+                leadPawns |= 1ULL << s;
+                squares[size++] = s ^ flipSquares;
+            }
+            leadPawnCount = size;
+            std::swap(squares[0], *std::max_element(squares, squares + leadPawnCount, pawnOrder));
+            file = fileOf(squares[0]);
+            if (file > 3) file = fileOf(squares[0] ^ 7);
+        }
+
+        if (table.kind == Kind::DTZ && (table.get(stm, file)->flags & STM) != stm &&
+            !(table.key == table.key2 && !table.hasPawns)) {
+            return false;
+        }
+
+        for (int s = 0; s < 64; s++) {
+            if (!pos.pieces[s] || (leadPawns >> s & 1)) continue;
+            squares[size] = s ^ flipSquares;
+            pieces[size++] = pos.pieces[s] ^ flipColour;
+        }
+
+        // Put the pieces in the stream's order
+        d = table.get(stm, file);
+        for (int i = leadPawnCount; i < size - 1; i++) {
+            for (int j = i + 1; j < size; j++) {
+                if (d->pieces[i] == pieces[j]) {
+                    std::swap(pieces[i], pieces[j]);
+                    std::swap(squares[i], squares[j]);
+                    break;
+                }
+            }
+        }
+
+        // The leading piece goes to files a-d
+        if (fileOf(squares[0]) > 3) {
+            for (int i = 0; i < size; i++) squares[i] ^= 7;
+        }
+
+        if (table.hasPawns) {
+            index = maps.leadPawn[leadPawnCount][squares[0]];
+            std::stable_sort(squares + 1, squares + leadPawnCount, pawnOrder);
+            for (int i = 1; i < leadPawnCount; i++)
+                index += maps.binomial[i][maps.pawns[squares[i]]];
+        } else {
+            // Without pawns, also to ranks 1-4, and the first piece of the
+            // leading group off the a1-h8 diagonal to below it
+            if (rankOf(squares[0]) > 3) {
+                for (int i = 0; i < size; i++) squares[i] ^= 56;
+            }
+            for (int i = 0; i < d->groupLength[0]; i++) {
+                if (!offDiagonal(squares[i])) continue;
+                if (offDiagonal(squares[i]) > 0) {
+                    for (int j = i; j < size; j++) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+                break;
+            }
+
+            if (table.hasUniquePieces) {
+                int adjust1 = squares[1] > squares[0];
+                int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+                if (offDiagonal(squares[0])) {
+                    index = (maps.a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+                } else if (offDiagonal(squares[1])) {
+                    index = (6 * 63 + rankOf(squares[0]) * 28 + maps.b1h1h7[squares[1]]) * 62 + squares[2] - adjust2;
+                } else if (offDiagonal(squares[2])) {
+                    index = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28
+                          + (rankOf(squares[1]) - adjust1) * 28 + maps.b1h1h7[squares[2]];
+                } else {
+                    index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6
+                          + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+                }
+            } else {
+                index = maps.kings[maps.a1d1d4[squares[0]]][squares[1]];
+            }
+        }
+
+        // The other groups, each as a set of squares, skipping squares
+        // taken by earlier groups (and rank 1 for the other side's pawns)
+        index *= d->groupIndex[0];
+        int* groupSquares = squares + d->groupLength[0];
+        bool remainingPawns = table.hasPawns && table.pawnCount[1];
+        for (int next = 1; d->groupLength[next]; next++) {
+            std::stable_sort(groupSquares, groupSquares + d->groupLength[next]);
+            uint64_t n = 0;
+            for (int i = 0; i < d->groupLength[next]; i++) {
+                int adjust = (int)std::count_if(squares, groupSquares, [&](int s) { return groupSquares[i] > s; });
+                n += maps.binomial[i + 1][groupSquares[i] - adjust - 8 * remainingPawns];
+            }
+            remainingPawns = false;
+            index += n * d->groupIndex[next];
+            groupSquares += d->groupLength[next];
+        }
+        return true;
+    }
+
+    // The stored value for pos: a WDL result, or for DTZ the distance for
+    // result wdl. CHANGE_SIDE when a DTZ table only holds the other side.
+    int probeTable(Kind kind, const Position& pos, int wdl, State& state) {
+        if (pos.pieceCount == 2)
+            return WDL_DRAW;
+        auto found = entriesByKey.find(pos.key);
+        if (found == entriesByKey.end()) {
+            state = State::FAIL;
+            return 0;
+        }
+        Table& table = kind == Kind::WDL ? found->second->wdl : found->second->dtz;
+        if (!load(table)) {
+            state = State::FAIL;
+            return 0;
+        }
+
+        PairsData* d;
+        int file;
+        uint64_t index;
+        if (!locate(table, pos, d, file, index)) {
+            state = State::CHANGE_SIDE;
+            return 0;
+        }
+        int value = decompress(d, index);
+        return kind == Kind::WDL ? value - 2 : mapDTZ(table, file, value, wdl);
+    }
+
+    bool canCastle(const Board& board) {
+        for (PieceColor color : { PieceColor::WHITE, PieceColor::BLACK }) {
+            int row = color == PieceColor::WHITE ? 7 : 0;
+            Piece* king = board.getPiece(row, 4);
+            if (board.hasKingMoved(color) || !king || king->getType() != PieceType::KING || king->getColor() != color)
+                continue;
+            for (int col : { 0, 7 }) {
+                Piece* rook = board.getPiece(row, col);
+                if (rook && rook->getType() == PieceType::ROOK && rook->getColor() == color &&
+                    !board.hasRookMoved(color, col == 7)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool isCapture(const Board& board, const Move& move) {
+        return board.getPiece(move.toRow, move.toCol) ||
+               (move.pieceMoved->getType() == PieceType::PAWN && move.fromCol != move.toCol);
+    }
+
+    bool isZeroing(const Board& board, const Move& move) {
+        return move.pieceMoved->getType() == PieceType::PAWN || isCapture(board, move);
+    }
+
+    // Every legal move, with the underpromotions and en passant captures
+    // the search's generator leaves out
+    std::vector<Move> legalMoves(const Board& board) {
+        MoveGenerator generator;
+        PieceColor us = board.getCurrentTurn();
+        std::vector<Move> moves = generator.generateLegalMoves(board, us);
+        size_t count = moves.size();
+        for (size_t i = 0; i < count; i++) {
+            if (moves[i].promotion != PieceType::QUEEN) continue;
+            for (PieceType type : { PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT }) {
+                Move underpromotion = moves[i];
+                underpromotion.promotion = type;
+                moves.push_back(underpromotion);
+            }
+        }
+
+        Move last = board.getLastMove();
+        if (last.pieceMoved && last.pieceMoved->getType() == PieceType::PAWN && std::abs(last.fromRow - last.toRow) == 2) {
+            for (int col : { last.toCol - 1, last.toCol + 1 }) {
+                if (col < 0 || col > 7) continue;
+                Piece* pawn = board.getPiece(last.toRow, col);
+                if (!pawn || pawn->getType() != PieceType::PAWN || pawn->getColor() != us) continue;
+                int toRow = (last.fromRow + last.toRow) / 2;
+                Board next = board;
+                if (next.movePiece(last.toRow, col, toRow, last.toCol))
+                    moves.emplace_back(last.toRow, col, toRow, last.toCol, pawn);
+            }
+        }
+        return moves;
+    }
+
+    Board play(const Board& board, const Move& move) {
+        Board next = board;
+        next.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
+        return next;
+    }
+
+    // Tables may store anything for a position with a winning capture or
+    // pawn move (and hold no en passant rights), so the result is the best
+    // of those moves and the stored value. ZEROING_BEST_MOVE when one of the
+    // moves decides it, since the DTZ table is then no help either.
+    template <bool CheckZeroing>
+    int search(const Board& board, State& state) {
+        int bestValue = WDL_LOSS;
+        std::vector<Move> moves = legalMoves(board);
+        size_t searched = 0;
+        for (const Move& move : moves) {
+            if (!isCapture(board, move) && (!CheckZeroing || move.pieceMoved->getType() != PieceType::PAWN))
+                continue;
+            searched++;
+            int value = -search<false>(play(board, move), state);
+            if (state == State::FAIL)
+                return WDL_DRAW;
+            if (value > bestValue) {
+                bestValue = value;
+                if (value >= WDL_WIN) {
+                    state = State::ZEROING_BEST_MOVE;
+                    return value;
+                }
+            }
+        }
+
+        bool onlyThese = searched && searched == moves.size();
+        int value = bestValue;
+        if (!onlyThese) {
+            value = probeTable(Kind::WDL, Position(board), WDL_DRAW, state);
+            if (state == State::FAIL)
+                return WDL_DRAW;
+        }
+        if (bestValue >= value) {
+            state = bestValue > WDL_DRAW || onlyThese ? State::ZEROING_BEST_MOVE : State::OK;
+            return bestValue;
+        }
+        state = State::OK;
+        return value;
+    }
+
+    int dtzBeforeZeroing(int wdl) {
+        return wdl == WDL_WIN ? 1 : wdl == WDL_CURSED_WIN ? 101 : wdl == WDL_BLESSED_LOSS ? -101 : wdl == WDL_LOSS ? -1 : 0;
+    }
+
+    // Plies to the next zeroing move, signed by the result: positive when
+    // winning, 100 more for a cursed win or blessed loss, 0 for a draw.
+    int probeDTZ(const Board& board, State& state) {
+        state = State::OK;
+        int wdl = search<true>(board, state);
+        if (state == State::FAIL || wdl == WDL_DRAW)
+            return 0;
+        if (state == State::ZEROING_BEST_MOVE)
+            return dtzBeforeZeroing(wdl);
+
+        int dtz = probeTable(Kind::DTZ, Position(board), wdl, state);
+        if (state == State::FAIL)
+            return 0;
+        if (state != State::CHANGE_SIDE)
+            return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * sign(wdl);
+
+        // The table holds the other side to move: take the best reply
+        int best = 0xFFFF;
+        for (const Move& move : legalMoves(board)) {
+            bool zeroing = isZeroing(board, move);
+            Board next = play(board, move);
+            // A zeroing move's own DTZ, not the one after it
+            dtz = zeroing ? -dtzBeforeZeroing(search<false>(next, state)) : -probeDTZ(next, state);
+            if (dtz == 1 && next.isCheckmate(next.getCurrentTurn()))
+                best = 1;
+            if (!zeroing)
+                dtz += sign(dtz);
+            if (dtz < best && sign(dtz) == sign(wdl))
+                best = dtz;
+            if (state == State::FAIL)
+                return 0;
+        }
+        return best == 0xFFFF ? -1 : best;
+    }
+
+    bool probeable(const Board& board) {
+        return board.getPieceCount() <= largestTable && !canCastle(board);
+    }
+}
+
+int Syzygy::init(const std::string& paths) {
+    entriesByKey.clear();
+    entries.clear();
+    largestTable = 0;
+    if (paths.empty() || paths == "<empty>")
+        return 0;
+
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    // The first directory holding a file wins
+    std::unordered_map<std::string, std::string> wdlFiles, dtzFiles;
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = paths.find(separator, start);
+        if (end == std::string::npos) end = paths.size();
+        std::error_code error;
+        for (const auto& file : std::filesystem::directory_iterator(paths.substr(start, end - start), error)) {
+            std::string extension = file.path().extension().string();
+            std::string name = file.path().stem().string();
+            if (extension == ".rtbw") wdlFiles.emplace(name, file.path().string());
+            else if (extension == ".rtbz") dtzFiles.emplace(name, file.path().string());
+        }
+        start = end + 1;
+    }
+
+    for (const auto& [name, path] : wdlFiles) {
+        auto entry = std::make_unique<Entry>();
+        if (!describe(name, entry->wdl) || entriesByKey.count(entry->wdl.key))
+            continue;
+        describe(name, entry->dtz);
+        entry->dtz.kind = Kind::DTZ;
+        entry->wdl.path = path;
+        auto dtz = dtzFiles.find(name);
+        if (dtz != dtzFiles.end()) entry->dtz.path = dtz->second;
+
+        entriesByKey[entry->wdl.key] = entry.get();
+        entriesByKey[entry->wdl.key2] = entry.get();
+        largestTable = std::max(largestTable, entry->wdl.pieceCount);
+        entries.push_back(std::move(entry));
+    }
+    return (int)entries.size();
+}
+
+int Syzygy::maxPieces() {
+    return largestTable;
+}
+
+bool Syzygy::probeWDL(const Board& board, WDL& result) {
+    if (!probeable(board))
+        return false;
+    State state = State::OK;
+    int value = search<false>(board, state);
+    if (state == State::FAIL)
+        return false;
+    result = WDL(value);
+    return true;
+}
+
+bool Syzygy::bestMove(const Board& board, Move& move, WDL& wdl, int& dtz) {
+    if (!probeable(board))
+        return false;
+
+    // Wins rank by fewest plies, losses by most, draws in between
+    int bestRank = INT_MIN;
+    for (const Move& candidate : legalMoves(board)) {
+        Board next = play(board, candidate);
+        State state = State::OK;
+        int value;
+        if (isZeroing(board, candidate)) {
+            value = dtzBeforeZeroing(-search<false>(next, state));
+        } else {
+            value = -probeDTZ(next, state);
+            value += sign(value);
+        }
+        if (state == State::FAIL)
+            return false;
+        if (value == 2 && next.isCheckmate(next.getCurrentTurn()))
+            value = 1;
+
+        int rank = value > 0 ? 10000 - value : value < 0 ? -10000 - value : 0;
+        if (rank > bestRank) {
+            bestRank = rank;
+            move = candidate;
+            dtz = value;
+        }
+    }
+    if (bestRank == INT_MIN)
+        return false;
+
+    wdl = dtz > 100 ? WDL::CURSED_WIN : dtz > 0 ? WDL::WIN : dtz < -100 ? WDL::BLESSED_LOSS
+        : dtz < 0 ? WDL::LOSS : WDL::DRAW;
+    return true;
+}
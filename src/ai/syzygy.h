@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../core/board.h"
+#include "../core/move.h"
+#include <string>
+
+// Syzygy tablebase probing. WDL files (.rtbw) hold the win/draw/loss result
+// of every position of a material balance, DTZ files (.rtbz) the distance in
+// plies to the next capture or pawn move that keeps it. Both count the
+// fifty-move rule: a cursed win is a win the rule turns into a draw, and a
+// blessed loss the same for the losing side.
+//
+// init() only lists the files; each one is memory-mapped and parsed the
+// first time a position needs it, under a lock, so probing is thread-safe
+// and tables that are never used cost nothing. Positions with castling
+// rights are never probed, since the tables do not hold them.
+namespace Syzygy {
+    const int MAX_PIECES = 7;
+
+    enum class WDL { LOSS = -2, BLESSED_LOSS = -1, DRAW = 0, CURSED_WIN = 1, WIN = 2 };
+
+    // paths holds directories separated by ':' (';' on Windows); empty or
+    // "<empty>" drops all tables. Not while probing. Returns the number of
+    // WDL tables found.
+    int init(const std::string& paths);
+
+    // Pieces in the largest table found, kings included; 0 without tables
+    int maxPieces();
+
+    // For the side to move. False if a table the probe needs is missing or
+    // unreadable.
+    bool probeWDL(const Board& board, WDL& result);
+
+    // The root move that keeps the best result: the quickest zeroing move
+    // when winning, the slowest when losing, and any drawing move in a
+    // draw. wdl is the result it keeps and dtz its distance from the root
+    // in plies (0 for a draw). Needs the DTZ tables as well.
+    bool bestMove(const Board& board, Move& move, WDL& wdl, int& dtz);
+}
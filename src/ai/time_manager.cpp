@@ -0,0 +1,48 @@
+#include "time_manager.h"
+#include <algorithm>
+
+void TimeManager::start(const SearchLimits& limits, PieceColor side) {
+    startTime = std::chrono::steady_clock::now();
+    fixedTime = false;
+
+    int timeLeft = side == PieceColor::WHITE ? limits.whiteTime : limits.blackTime;
+    int increment = side == PieceColor::WHITE ? limits.whiteIncrement : limits.blackIncrement;
+
+    if (limits.infinite) {
+        timed = false;
+    } else if (limits.moveTime > 0) {
+        timed = true;
+        fixedTime = true;
+        softMs = hardMs = std::max(1, limits.moveTime - MOVE_OVERHEAD_MS);
+    } else if (timeLeft > 0) {
+        timed = true;
+        int64_t available = std::max(1, timeLeft - MOVE_OVERHEAD_MS);
+        int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+
+        // Aim for an even share of the remaining time plus most of the
+        // increment, but never let one move eat more than half the clock.
+        softMs = available / movesToGo + increment * 3 / 4;
+        hardMs = std::min<int64_t>(softMs * 4, available / 2);
+        softMs = std::min(softMs, hardMs);
+        softMs = std::max<int64_t>(softMs, 1);
+        hardMs = std::max<int64_t>(hardMs, 1);
+    } else {
+        timed = false;
+    }
+}
+
+int64_t TimeManager::elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+bool TimeManager::softLimitReached(int bestMoveStability) const {
+    if (!timed) return false;
+    if (fixedTime) return elapsed() >= hardMs;
+
+    // A best move that keeps changing earns more time; one that has held for
+    // several iterations lets us move early.
+    static const double stabilityScale[] = { 2.0, 1.3, 1.0, 0.8, 0.7 };
+    double scale = stabilityScale[std::min(bestMoveStability, 4)];
+    return elapsed() >= std::min<int64_t>(hardMs, (int64_t)(softMs * scale));
+}
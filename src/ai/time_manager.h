@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../core/piece.h"
+#include <chrono>
+#include <cstdint>
+
+// What a search may spend. Every field is optional; zero means "no limit".
+// With no limit at all (and not infinite) the search stops at MAX_DEPTH.
+struct SearchLimits {
+    int whiteTime = 0;          // remaining clock time in ms
+    int blackTime = 0;
+    int whiteIncrement = 0;     // increment per move in ms
+    int blackIncrement = 0;
+    int movesToGo = 0;          // moves until the next time control
+    int moveTime = 0;           // exact time for this move in ms
+    uint64_t nodes = 0;         // counted on the main search thread
+    int depth = 0;
+    bool infinite = false;      // search until stopped from outside
+    bool ponder = false;        // search on the opponent's time until ponderhit
+
+    // Thinking time the interactive front ends give the computer per move
+    static const int DEFAULT_MOVE_TIME_MS = 3000;
+
+    static SearchLimits fixedDepth(int depth) {
+        SearchLimits limits;
+        limits.depth = depth;
+        return limits;
+    }
+
+    static SearchLimits fixedTime(int milliseconds) {
+        SearchLimits limits;
+        limits.moveTime = milliseconds;
+        return limits;
+    }
+};
+
+// Turns SearchLimits into two deadlines. The soft limit is checked between
+// iterations and scaled by how stable the best move has been; the hard limit
+// is checked inside the search and aborts it.
+class TimeManager {
+public:
+    void start(const SearchLimits& limits, PieceColor side);
+
+    int64_t elapsed() const;
+    bool isTimed() const { return timed; }
+    int64_t softLimit() const { return softMs; }
+    int64_t hardLimit() const { return hardMs; }
+
+    // bestMoveStability counts consecutive iterations with the same best move
+    bool softLimitReached(int bestMoveStability) const;
+    bool hardLimitReached() const { return timed && elapsed() >= hardMs; }
+
+private:
+    // Time kept back for move transmission and process scheduling
+    static const int MOVE_OVERHEAD_MS = 20;
+    static const int DEFAULT_MOVES_TO_GO = 30;
+
+    std::chrono::steady_clock::time_point startTime;
+    bool timed = false;
+    bool fixedTime = false;     // movetime: use all of it, ignore stability
+    int64_t softMs = 0;
+    int64_t hardMs = 0;
+};
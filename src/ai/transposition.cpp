@@ -0,0 +1,351 @@
+#include "transposition.h"
+#include "../core/zobrist.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Entry layout, low to high bits:
+// key (16) | score (16) | from (6) | to (6) | depth (8) | bound (2) | generation (6)
+namespace {
+    const int GENERATION_MASK = 0x3F;
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    // Smaller tables are cleared faster than threads can be started
+    const size_t PARALLEL_CLEAR_BYTES = 1024 * 1024 * 1024;
+
+    const char FILE_MAGIC[8] = { 'P', 'I', 'X', 'Y', 'H', 'A', 'S', 'H' };
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    // Bump whenever the entry or cluster layout changes
+    const uint32_t FORMAT_VERSION = 1;
+
+    uint16_t keyOf(uint64_t data) { return (uint16_t)data; }
+    int depthOf(uint64_t data) { return (int)((data >> 44) & 0xFF); }
+    TTBound boundOf(uint64_t data) { return (TTBound)((data >> 52) & 0x3); }
+    int generationOf(uint64_t data) { return (int)((data >> 54) & GENERATION_MASK); }
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+#ifdef __unix__
+    if (mappedBase) {
+        munmap(mappedBase, mappedBytes);
+        mappedBase = nullptr;
+        mappedBytes = 0;
+        clusters = nullptr;
+        return;
+    }
+#endif
+    std::free(clusters);
+    clusters = nullptr;
+}
+
+void TranspositionTable::allocate(size_t bytes, size_t alignment) {
+    release();
+    clusters = static_cast<Cluster*>(std::aligned_alloc(alignment, bytes));
+    if (!clusters) {
+        clusterCount = 0;
+        megabytes = 0;
+        throw std::runtime_error("Failed to allocate transposition table");
+    }
+}
+
+void TranspositionTable::resize(size_t megabytes, bool hugePages) {
+    megabytes = std::max<size_t>(1, megabytes);
+    size_t bytes = megabytes * 1024 * 1024;
+
+    // Huge pages need the table aligned to the huge page size; otherwise a
+    // cache line is enough.
+    size_t alignment = (hugePages && bytes >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : 64;
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+
+    allocate(bytes, alignment);
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == HUGE_PAGE_SIZE)
+        madvise(clusters, bytes, MADV_HUGEPAGE);
+#endif
+
+    clusterCount = bytes / sizeof(Cluster);
+    this->megabytes = megabytes;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    // Zeroing gigabytes is slow on one core, so split it across threads;
+    // the calling thread takes the first chunk.
+    size_t threadCount = clusterCount * sizeof(Cluster) >= PARALLEL_CLEAR_BYTES
+        ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+    size_t chunk = (clusterCount + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threadCount; t++) {
+        size_t begin = std::min(clusterCount, t * chunk);
+        size_t end = std::min(clusterCount, begin + chunk);
+        workers.emplace_back([this, begin, end] {
+            std::memset(static_cast<void*>(clusters + begin), 0, (end - begin) * sizeof(Cluster));
+        });
+    }
+    std::memset(static_cast<void*>(clusters), 0, std::min(clusterCount, chunk) * sizeof(Cluster));
+    for (auto& worker : workers) worker.join();
+    generation = 0;
+    if (mappedBase) {
+        FileHeader header = makeHeader();
+        std::memcpy(mappedBase, &header, sizeof(header));
+    }
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & GENERATION_MASK;
+    if (mappedBase)
+        static_cast<FileHeader*>(mappedBase)->generation = generation;
+}
+
+TranspositionTable::FileHeader TranspositionTable::makeHeader() const {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.formatVersion = FORMAT_VERSION;
+    header.keyFingerprint = Zobrist::fingerprint();
+    header.clusterCount = clusterCount;
+    header.clusterSize = CLUSTER_SIZE;
+    header.generation = generation;
+    return header;
+}
+
+void TranspositionTable::validateHeader(const FileHeader& header, const std::string& path) {
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Not a hash file: " + path);
+    if (header.byteOrder != BYTE_ORDER_MARK)
+        throw std::runtime_error("Hash file written with a different byte order: " + path);
+    if (header.formatVersion != FORMAT_VERSION || header.clusterSize != CLUSTER_SIZE)
+        throw std::runtime_error("Hash file has an incompatible entry format: " + path);
+    if (header.keyFingerprint != Zobrist::fingerprint())
+        throw std::runtime_error("Hash file was made with different hash keys: " + path);
+    if (header.clusterCount == 0)
+        throw std::runtime_error("Hash file is empty: " + path);
+}
+
+void TranspositionTable::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        throw std::runtime_error("Cannot write hash file: " + path);
+
+    std::vector<char> header(HEADER_SIZE, 0);
+    FileHeader fields = makeHeader();
+    std::memcpy(header.data(), &fields, sizeof(fields));
+    file.write(header.data(), header.size());
+    file.write(reinterpret_cast<const char*>(clusters), clusterCount * sizeof(Cluster));
+    if (!file)
+        throw std::runtime_error("Failed to write hash file: " + path);
+}
+
+void TranspositionTable::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Cannot open hash file: " + path);
+
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        throw std::runtime_error("Not a hash file: " + path);
+    validateHeader(header, path);
+
+    // The cluster count decides which cluster a position maps to, so the
+    // table takes the file's size. The file is checked and read into a new
+    // buffer first, so a rejected file leaves the current table as it was.
+    file.seekg(0, std::ios::end);
+    size_t fileSize = (size_t)file.tellg();
+    if (fileSize < HEADER_SIZE || header.clusterCount > (fileSize - HEADER_SIZE) / sizeof(Cluster))
+        throw std::runtime_error("Hash file is truncated: " + path);
+    size_t bytes = header.clusterCount * sizeof(Cluster);
+
+    Cluster* loaded = static_cast<Cluster*>(std::aligned_alloc(64, (bytes + 63) / 64 * 64));
+    if (!loaded)
+        throw std::runtime_error("Failed to allocate transposition table");
+    file.seekg(HEADER_SIZE);
+    if (!file.read(reinterpret_cast<char*>(loaded), bytes)) {
+        std::free(loaded);
+        throw std::runtime_error("Failed to read hash file: " + path);
+    }
+
+    release();
+    clusters = loaded;
+    clusterCount = header.clusterCount;
+    megabytes = std::max<size_t>(1, bytes >> 20);
+    generation = header.generation & GENERATION_MASK;
+}
+
+void TranspositionTable::mapFile(const std::string& path, size_t megabytes) {
+#ifdef __unix__
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open hash file: " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read hash file: " + path);
+    }
+    FileHeader header;
+    bool created = info.st_size == 0;
+    size_t count = std::max<size_t>(1, megabytes) * 1024 * 1024 / sizeof(Cluster);
+    const char* error = nullptr;
+    if (created) {
+        // A new file reads as zeros, which is an empty table
+        if (ftruncate(fd, HEADER_SIZE + count * sizeof(Cluster)) != 0)
+            error = "Cannot size hash file: ";
+    } else if ((size_t)info.st_size < HEADER_SIZE || pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        error = "Not a hash file: ";
+    } else {
+        try {
+            validateHeader(header, path);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        count = header.clusterCount;
+        if (count > ((size_t)info.st_size - HEADER_SIZE) / sizeof(Cluster))
+            error = "Hash file is truncated: ";
+    }
+
+    void* base = MAP_FAILED;
+    size_t bytes = HEADER_SIZE + count * sizeof(Cluster);
+    if (!error) {
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+            error = "Cannot map hash file: ";
+    }
+    close(fd);
+    if (error)
+        throw std::runtime_error(error + path);
+
+    release();
+    mappedBase = base;
+    mappedBytes = bytes;
+    clusters = reinterpret_cast<Cluster*>(static_cast<char*>(base) + HEADER_SIZE);
+    clusterCount = count;
+    this->megabytes = std::max<size_t>(1, (count * sizeof(Cluster)) >> 20);
+    generation = created ? 0 : header.generation & GENERATION_MASK;
+
+    FileHeader current = makeHeader();
+    std::memcpy(mappedBase, &current, sizeof(current));
+#else
+    (void)path;
+    (void)megabytes;
+    throw std::runtime_error("Memory-mapped hash files are not supported on this platform");
+#endif
+}
+
+uint64_t TranspositionTable::pack(uint64_t hash, int depth, int score, TTBound bound, uint8_t generation, const Move& bestMove) {
+    uint64_t from = bestMove.fromRow * 8 + bestMove.fromCol;
+    uint64_t to = bestMove.toRow * 8 + bestMove.toCol;
+    score = std::clamp(score, -32767, 32767);
+    return (uint64_t)(uint16_t)hash
+         | ((uint64_t)(uint16_t)(int16_t)score << 16)
+         | (from << 32)
+         | (to << 38)
+         | ((uint64_t)std::clamp(depth, 0, 255) << 44)
+         | ((uint64_t)bound << 52)
+         | ((uint64_t)(generation & GENERATION_MASK) << 54);
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data) {
+    TTEntry entry;
+    entry.score = (int16_t)(uint16_t)(data >> 16);
+    entry.depth = depthOf(data);
+    entry.bound = boundOf(data);
+    int from = (int)((data >> 32) & 0x3F);
+    int to = (int)((data >> 38) & 0x3F);
+    entry.bestMove = Move(from / 8, from % 8, to / 8, to % 8, nullptr);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t hash, TTEntry& entry) const {
+    const Cluster& cluster = clusters[clusterIndex(hash)];
+    uint16_t key = (uint16_t)hash;
+
+    for (int i = 0; i < CLUSTER_SIZE; i++) {
+        uint64_t data = cluster.entries[i].load(std::memory_order_relaxed);
+        if (boundOf(data) != TTBound::NONE && keyOf(data) == key) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t hash, int depth, int score, TTBound bound, const Move& bestMove) {
+    Cluster& cluster = clusters[clusterIndex(hash)];
+    uint16_t key = (uint16_t)hash;
+    Move move = bestMove;
+
+    // Depth-plus-age replacement: reuse this position's own slot if present,
+    // otherwise evict the entry with the lowest depth minus a penalty for
+    // every search it has gone stale. Empty slots always lose.
+    int victim = 0;
+    int victimPriority = 1 << 30;
+    for (int i = 0; i < CLUSTER_SIZE; i++) {
+        uint64_t data = cluster.entries[i].load(std::memory_order_relaxed);
+        if (boundOf(data) == TTBound::NONE) {
+            if (victimPriority > -(1 << 20)) {
+                victim = i;
+                victimPriority = -(1 << 20);
+            }
+            continue;
+        }
+
+        int age = (generation - generationOf(data)) & GENERATION_MASK;
+        if (keyOf(data) == key) {
+            // Within this search a deeper result for the same position
+            // survives a shallower non-exact one; two plies of slack favour
+            // the newer, usually better-informed result.
+            if (age == 0 && bound != TTBound::EXACT && depth + 2 < depthOf(data))
+                return;
+
+            // Keep the old best move rather than overwrite it with none
+            bool hasMove = move.fromRow != move.toRow || move.fromCol != move.toCol;
+            if (!hasMove)
+                move = unpack(data).bestMove;
+
+            victim = i;
+            break;
+        }
+
+        int priority = depthOf(data) - 8 * age;
+        if (priority < victimPriority) {
+            victim = i;
+            victimPriority = priority;
+        }
+    }
+
+    cluster.entries[victim].store(pack(hash, depth, score, bound, generation, move), std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sampleClusters = std::min<size_t>(clusterCount, 1000 / CLUSTER_SIZE);
+    int used = 0;
+    for (size_t c = 0; c < sampleClusters; c++) {
+        for (int i = 0; i < CLUSTER_SIZE; i++) {
+            uint64_t data = clusters[c].entries[i].load(std::memory_order_relaxed);
+            if (boundOf(data) != TTBound::NONE && generationOf(data) == generation)
+                used++;
+        }
+    }
+    return (int)(used * 1000 / (sampleClusters * CLUSTER_SIZE));
+}
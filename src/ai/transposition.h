@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../core/move.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What a stored score says about the true value of the position.
+enum class TTBound : uint8_t { NONE, UPPER, LOWER, EXACT };
+
+struct TTEntry {
+    int score;
+    int depth;
+    TTBound bound;
+    Move bestMove;      // from == to when the entry has no move
+};
+
+// Transposition table shared by all search threads, sized in megabytes.
+//
+// Each entry is a single 64-bit word holding a 16-bit key fragment, the
+// move, score, depth, bound and search generation. Reading or writing an
+// entry is one relaxed atomic access, so the table is lock-free and never
+// returns a torn entry. Four entries form a 32-byte cluster; a position maps
+// to one cluster using the high bits of its hash and is verified with the
+// low 16 bits, and the allocation is cache-line aligned so a probe touches a
+// single line.
+//
+// The table persists across searches. Each search bumps a 6-bit generation
+// that is stored in every entry, so stale entries can be recognised and
+// replaced first.
+//
+// It can also outlive the process: save() and load() write and read it as a
+// file, and mapFile() keeps it in a memory-mapped file that is updated as the
+// search runs. All three use the same format, a header followed by the
+// clusters as they are in memory. The header records the entry format, byte
+// order and a fingerprint of the Zobrist keys, and files that do not match
+// this build are rejected. None of these may be called during a search.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocates and clears the table. With hugePages set, large tables are
+    // backed by transparent huge pages where the OS supports it.
+    void resize(size_t megabytes, bool hugePages = true);
+    size_t sizeMB() const { return megabytes; }
+
+    void clear();
+    void newSearch();
+
+    // Throw std::runtime_error on I/O errors or an incompatible file, leaving
+    // the current table in place. load() takes its size from the file; so
+    // does mapFile(), unless the file does not exist yet and is created with
+    // megabytes.
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+    void mapFile(const std::string& path, size_t megabytes);
+    bool isMapped() const { return mappedBase != nullptr; }
+    bool probe(uint64_t hash, TTEntry& entry) const;
+    void store(uint64_t hash, int depth, int score, TTBound bound, const Move& bestMove);
+
+    // Pulls the cluster for hash into cache ahead of the probe.
+    void prefetch(uint64_t hash) const {
+        __builtin_prefetch(&clusters[clusterIndex(hash)]);
+    }
+
+    // Permille of sampled entries written during the current search.
+    int hashfull() const;
+
+private:
+    static const int CLUSTER_SIZE = 4;
+
+    struct alignas(32) Cluster {
+        std::atomic<uint64_t> entries[CLUSTER_SIZE];
+    };
+
+    size_t clusterIndex(uint64_t hash) const {
+        return (size_t)(((unsigned __int128)hash * clusterCount) >> 64);
+    }
+
+    // Page-sized so mapped clusters stay aligned
+    static const size_t HEADER_SIZE = 4096;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t byteOrder;
+        uint32_t formatVersion;
+        uint64_t keyFingerprint;
+        uint64_t clusterCount;
+        uint32_t clusterSize;
+        uint32_t generation;
+    };
+
+    FileHeader makeHeader() const;
+    static void validateHeader(const FileHeader& header, const std::string& path);
+    void allocate(size_t bytes, size_t alignment);
+    void release();
+
+    static uint64_t pack(uint64_t hash, int depth, int score, TTBound bound, uint8_t generation, const Move& bestMove);
+    static TTEntry unpack(uint64_t data);
+
+    Cluster* clusters = nullptr;
+    void* mappedBase = nullptr;     // set when the table lives in a mapped file
+    size_t mappedBytes = 0;
+    size_t clusterCount = 0;
+    size_t megabytes = 0;
+    uint8_t generation = 0;
+};
@@ -0,0 +1,310 @@
+#include "tuner.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+    double sigmoid(double k, double score) {
+        return 1.0 / (1.0 + std::pow(10.0, -k * score / 400.0));
+    }
+
+    // Runs fn(threadIndex, begin, end) over contiguous slices of [0, count).
+    template <typename Fn>
+    void parallelFor(int threads, size_t count, Fn fn) {
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (int t = 0; t < threads; t++) {
+            size_t begin = std::min(count, t * chunk);
+            size_t end = std::min(count, begin + chunk);
+            workers.emplace_back(fn, t, begin, end);
+        }
+        for (auto& worker : workers) worker.join();
+    }
+
+    // The result field comes after the four FEN fields: the operand of a c9
+    // opcode, or otherwise the last token of the line. Numbers only count
+    // in brackets, so a trailing fullmove clock is not read as a result.
+    bool parseResult(const std::string& line, float& result) {
+        std::istringstream ss(line);
+        std::string token, field;
+        for (int i = 0; i < 4; i++)
+            if (!(ss >> token)) return false;
+
+        bool afterC9 = false;
+        while (ss >> token) {
+            if (afterC9) { field = token; break; }
+            if (token == "c9") afterC9 = true;
+            else field = token;
+        }
+
+        bool bracketed = field.size() > 2 && field.front() == '[' && field.back() == ']';
+        field.erase(std::remove_if(field.begin(), field.end(), [](char c) {
+            return c == '"' || c == ';' || c == '[' || c == ']';
+        }), field.end());
+
+        if (field == "1-0") { result = 1.0f; return true; }
+        if (field == "0-1") { result = 0.0f; return true; }
+        if (field == "1/2-1/2") { result = 0.5f; return true; }
+        if (!bracketed) return false;
+
+        char* end;
+        result = std::strtof(field.c_str(), &end);
+        return *end == '\0' && result >= 0.0f && result <= 1.0f;
+    }
+
+    const char* pieceNames[6] = { "pawn", "rook", "knight", "bishop", "queen", "king" };
+
+}
+
+Tuner::Tuner(const TunerOptions& options) : options(options), k(options.scalingK) {
+    const int* defaults = evalParamData(defaultEvalParams);
+    weights.assign(defaults, defaults + EVAL_PARAM_COUNT);
+}
+
+int Tuner::threadCount() const {
+    if (options.threads > 0) return options.threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool Tuner::loadDataset(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening dataset: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) lines.push_back(std::move(line));
+    }
+
+    // Coefficient extraction is the expensive part (one evaluate() trace per
+    // position), so it runs once here, in parallel, and never again.
+    int threads = threadCount();
+    std::vector<std::vector<Coefficient>> threadCoefficients(threads);
+    std::vector<std::vector<Position>> threadPositions(threads);
+    std::vector<size_t> skipped(threads, 0);
+
+    parallelFor(threads, lines.size(), [&](int t, size_t begin, size_t end) {
+        Board board;
+        std::string fen;
+        for (size_t i = begin; i < end; i++) {
+            float result;
+            // Clock fields are often missing or replaced by EPD opcodes
+            if (!parseResult(lines[i], result) || !Board::extractEPDPosition(lines[i], fen)) {
+                skipped[t]++;
+                continue;
+            }
+            board.loadFEN(fen + " 0 1");
+
+            EvalParams trace{};
+            evaluate(board, defaultEvalParams, &trace);
+
+            Position position;
+            position.offset = threadCoefficients[t].size();
+            position.result = result;
+            position.count = 0;
+            const int* traceData = evalParamData(trace);
+            for (int index = 0; index < EVAL_PARAM_COUNT; index++) {
+                if (traceData[index] == 0) continue;
+                threadCoefficients[t].push_back({ (uint16_t)index, (int16_t)traceData[index] });
+                position.count++;
+            }
+            threadPositions[t].push_back(position);
+        }
+    });
+
+    size_t totalSkipped = 0;
+    for (int t = 0; t < threads; t++) {
+        uint64_t base = coefficients.size();
+        coefficients.insert(coefficients.end(), threadCoefficients[t].begin(), threadCoefficients[t].end());
+        for (Position position : threadPositions[t]) {
+            position.offset += base;
+            positions.push_back(position);
+        }
+        totalSkipped += skipped[t];
+    }
+
+    std::cout << "Loaded " << positions.size() << " positions (" << coefficients.size()
+              << " coefficients, " << totalSkipped << " lines skipped)" << std::endl;
+    return !positions.empty();
+}
+
+double Tuner::linearEval(const Position& position) const {
+    double score = 0.0;
+    const Coefficient* coefficient = &coefficients[position.offset];
+    for (int i = 0; i < position.count; i++) {
+        score += weights[coefficient[i].index] * coefficient[i].value;
+    }
+    return score;
+}
+
+double Tuner::meanError(double scale) const {
+    int threads = threadCount();
+    std::vector<double> errors(threads, 0.0);
+    parallelFor(threads, positions.size(), [&](int t, size_t begin, size_t end) {
+        double error = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            double diff = positions[i].result - sigmoid(scale, linearEval(positions[i]));
+            error += diff * diff;
+        }
+        errors[t] = error;
+    });
+
+    double total = 0.0;
+    for (double error : errors) total += error;
+    return total / positions.size();
+}
+
+double Tuner::computeOptimalK() {
+    // Golden-section search; the error is unimodal in K for a fixed weight set.
+    const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+    double lo = 0.0, hi = 5.0;
+    double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+    double errorA = meanError(a), errorB = meanError(b);
+    while (hi - lo > 1e-4) {
+        if (errorA < errorB) {
+            hi = b; b = a; errorB = errorA;
+            a = hi - ratio * (hi - lo);
+            errorA = meanError(a);
+        } else {
+            lo = a; a = b; errorA = errorB;
+            b = lo + ratio * (hi - lo);
+            errorB = meanError(b);
+        }
+    }
+    k = (lo + hi) / 2.0;
+    std::cout << "Optimal K: " << k << " (error " << meanError(k) << ")" << std::endl;
+    return k;
+}
+
+double Tuner::computeGradient(std::vector<double>& gradient) const {
+    int threads = threadCount();
+    std::vector<std::vector<double>> threadGradients(threads, std::vector<double>(EVAL_PARAM_COUNT, 0.0));
+    std::vector<double> errors(threads, 0.0);
+
+    parallelFor(threads, positions.size(), [&](int t, size_t begin, size_t end) {
+        std::vector<double>& local = threadGradients[t];
+        double error = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            const Position& position = positions[i];
+            double predicted = sigmoid(k, linearEval(position));
+            double diff = position.result - predicted;
+            error += diff * diff;
+
+            // d(diff^2)/d(score), leaving out the constant factors
+            double term = -diff * predicted * (1.0 - predicted);
+            const Coefficient* coefficient = &coefficients[position.offset];
+            for (int c = 0; c < position.count; c++) {
+                local[coefficient[c].index] += term * coefficient[c].value;
+            }
+        }
+        errors[t] = error;
+    });
+
+    const double scale = 2.0 * std::log(10.0) * k / 400.0 / positions.size();
+    gradient.assign(EVAL_PARAM_COUNT, 0.0);
+    for (const auto& local : threadGradients) {
+        for (int i = 0; i < EVAL_PARAM_COUNT; i++) gradient[i] += local[i] * scale;
+    }
+
+    double total = 0.0;
+    for (double error : errors) total += error;
+    return total / positions.size();
+}
+
+void Tuner::run() {
+    if (k <= 0.0) computeOptimalK();
+
+    // Adam keeps the step size in centipawns regardless of how often a
+    // weight's feature occurs in the data.
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> gradient, momentum(EVAL_PARAM_COUNT, 0.0), velocity(EVAL_PARAM_COUNT, 0.0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= options.epochs; epoch++) {
+        double error = computeGradient(gradient);
+
+        for (int i = 0; i < EVAL_PARAM_COUNT; i++) {
+            momentum[i] = beta1 * momentum[i] + (1.0 - beta1) * gradient[i];
+            velocity[i] = beta2 * velocity[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+            double mHat = momentum[i] / (1.0 - std::pow(beta1, epoch));
+            double vHat = velocity[i] / (1.0 - std::pow(beta2, epoch));
+            weights[i] -= options.learningRate * mHat / (std::sqrt(vHat) + epsilon);
+        }
+
+        if (epoch % options.reportInterval == 0 || epoch == options.epochs) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Epoch " << epoch << " error " << std::setprecision(8) << error
+                      << " (" << std::setprecision(3) << seconds / epoch << "s/epoch)" << std::endl;
+        }
+    }
+}
+
+EvalParams Tuner::getParams() const {
+    EvalParams params;
+    int* data = evalParamData(params);
+    for (int i = 0; i < EVAL_PARAM_COUNT; i++) {
+        data[i] = (int)std::lround(weights[i]);
+    }
+    return params;
+}
+
+void Tuner::printParams(std::ostream& out, const EvalParams& params) {
+    out << "const EvalParams defaultEvalParams = {\n";
+    out << "    // pieceValue: pawn, rook, knight, bishop, queen, king\n    {";
+    for (int type = 0; type < 6; type++) {
+        out << (type ? ", " : " ") << params.pieceValue[type];
+    }
+    out << " },\n    {\n";
+    for (int type = 0; type < 6; type++) {
+        out << "        // " << pieceNames[type] << "\n";
+        for (int row = 0; row < 8; row++) {
+            out << (row == 0 ? "        { {" : "          {");
+            for (int col = 0; col < 8; col++) {
+                out << std::setw(4) << params.pst[type][row][col] << (col < 7 ? "," : "");
+            }
+            out << (row == 7 ? "} },\n" : "},\n");
+        }
+    }
+    out << "    },\n";
+    out << "    " << params.knightRimPenalty << ", // knightRimPenalty\n";
+    out << "    " << params.displacedKingPenalty << ", // displacedKingPenalty\n";
+    out << "    " << params.centerControlBonus << ", // centerControlBonus\n";
+    out << "    " << params.knightDevelopmentBonus << ", // knightDevelopmentBonus\n";
+    out << "    " << params.bishopDevelopmentBonus << ", // bishopDevelopmentBonus\n";
+    out << "    " << params.isolatedPawnPenalty << ", // isolatedPawnPenalty\n";
+    out << "    " << params.uncastledKingPenalty << ", // uncastledKingPenalty\n";
+    out << "    " << params.castledKingBonus << ", // castledKingBonus\n";
+    out << "};\n";
+}
+
+bool Tuner::readParams(std::istream& in, EvalParams& params) {
+    std::vector<int> values;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find("//"));
+        for (size_t i = 0; i < line.size();) {
+            bool negative = line[i] == '-' && i + 1 < line.size() && std::isdigit((unsigned char)line[i + 1]);
+            if (!negative && !std::isdigit((unsigned char)line[i])) {
+                i++;
+                continue;
+            }
+            size_t end;
+            values.push_back(std::stoi(line.substr(i), &end));
+            i += end;
+        }
+    }
+    if (values.size() != (size_t)EVAL_PARAM_COUNT) return false;
+    std::copy(values.begin(), values.end(), evalParamData(params));
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "evaluate.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TunerOptions {
+    int epochs = 1000;
+    int threads = 0;            // 0 = one per hardware thread
+    double learningRate = 1.0;  // Adam step size, in centipawns
+    double scalingK = 0.0;      // sigmoid scale; 0 = fit to the dataset first
+    int reportInterval = 50;
+};
+
+// Texel tuner for EvalParams. evaluate() is linear in its weights, so each
+// position is reduced once, up front, to the sparse coefficient vector that
+// evaluate()'s trace produces. An epoch is then a sparse dot product and a
+// gradient accumulation per position, spread across all threads.
+class Tuner {
+public:
+    explicit Tuner(const TunerOptions& options);
+
+    // Reads "<fen> <result>" lines, where the result is 1-0 / 0-1 / 1/2-1/2
+    // or a bracketed [1.0]/[0.5]/[0.0], either last on the line or as the
+    // (optionally quoted) operand of a c9 opcode.
+    bool loadDataset(const std::string& path);
+    double computeOptimalK();
+    void run();
+
+    size_t positionCount() const { return positions.size(); }
+    EvalParams getParams() const;
+    static void printParams(std::ostream& out, const EvalParams& params);
+    // Reads what printParams() writes: every integer outside // comments, in
+    // declaration order. False unless there are exactly EVAL_PARAM_COUNT.
+    static bool readParams(std::istream& in, EvalParams& params);
+
+private:
+    struct Coefficient {
+        uint16_t index;
+        int16_t value;
+    };
+
+    struct Position {
+        uint64_t offset;    // first coefficient in `coefficients`
+        float result;       // 1 = white win, 0.5 = draw, 0 = black win
+        uint16_t count;
+    };
+
+    int threadCount() const;
+    double linearEval(const Position& position) const;
+    double meanError(double k) const;
+    double computeGradient(std::vector<double>& gradient) const;
+
+    TunerOptions options;
+    double k;
+    std::vector<Coefficient> coefficients;
+    std::vector<Position> positions;
+    std::vector<double> weights;
+};
@@ -6,6 +6,8 @@
 #include "queen.h"
 #include "king.h"
 #include "move.h"
+#include "zobrist.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -54,20 +56,31 @@ void Board::setupBoard() {
         board[6][i] = new Pawn(PieceColor::WHITE);
     }
 
-    board[0][0] = board[0][7] = new Rook(PieceColor::BLACK);
-    board[7][0] = board[7][7] = new Rook(PieceColor::WHITE);
+    // Every square owns its piece; the destructor deletes each one
+    board[0][0] = new Rook(PieceColor::BLACK);
+    board[0][7] = new Rook(PieceColor::BLACK);
+    board[7][0] = new Rook(PieceColor::WHITE);
+    board[7][7] = new Rook(PieceColor::WHITE);
 
-    board[0][1] = board[0][6] = new Knight(PieceColor::BLACK);
-    board[7][1] = board[7][6] = new Knight(PieceColor::WHITE);
+    board[0][1] = new Knight(PieceColor::BLACK);
+    board[0][6] = new Knight(PieceColor::BLACK);
+    board[7][1] = new Knight(PieceColor::WHITE);
+    board[7][6] = new Knight(PieceColor::WHITE);
 
-    board[0][2] = board[0][5] = new Bishop(PieceColor::BLACK);
-    board[7][2] = board[7][5] = new Bishop(PieceColor::WHITE);
+    board[0][2] = new Bishop(PieceColor::BLACK);
+    board[0][5] = new Bishop(PieceColor::BLACK);
+    board[7][2] = new Bishop(PieceColor::WHITE);
+    board[7][5] = new Bishop(PieceColor::WHITE);
 
     board[0][3] = new Queen(PieceColor::BLACK);
     board[7][3] = new Queen(PieceColor::WHITE);
 
     board[0][4] = new King(PieceColor::BLACK);
     board[7][4] = new King(PieceColor::WHITE);
+    pieceCount = 32;
+
+    lastMove = Move();
+    refreshHash();
 }
 
 void Board::printBoard() const {
@@ -96,7 +109,7 @@ void Board::printBoard() const {
     }
 }
 
-bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
+bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol, PieceType promotion) {
     if (fromRow < 0 || fromRow >= 8 || fromCol < 0 || fromCol >= 8 ||
         toRow < 0 || toRow >= 8 || toCol < 0 || toCol >= 8) {
         printMessage("Move coordinates out of bounds!");
@@ -114,12 +127,24 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
         return false;
     }
 
+    return currentTurn == PieceColor::WHITE
+        ? movePieceFor<PieceColor::WHITE>(piece, fromRow, fromCol, toRow, toCol, promotion)
+        : movePieceFor<PieceColor::BLACK>(piece, fromRow, fromCol, toRow, toCol, promotion);
+}
+
+// The rest of movePiece() for the side to move, Us, which owns piece
+template <PieceColor Us>
+bool Board::movePieceFor(Piece* piece, int fromRow, int fromCol, int toRow, int toCol, PieceType promotion) {
+    using Traits = ColorTraits<Us>;
+    constexpr const char* side = Traits::white ? "White" : "Black";
+    bool& kingMoved = Traits::white ? hasWhiteKingMoved : hasBlackKingMoved;
+    bool& kingsideRookMoved = Traits::white ? hasWhiteKingsideRookMoved : hasBlackKingsideRookMoved;
+    bool& queensideRookMoved = Traits::white ? hasWhiteQueensideRookMoved : hasBlackQueensideRookMoved;
+
     bool isEnPassant = false;
     int enPassantCapturedRow = -1, enPassantCapturedCol = -1;
 
     if (piece->getType() == PieceType::PAWN) {
-        Pawn* pawn = static_cast<Pawn*>(piece);
-
         // En passant detection:
         if (lastMove.pieceMoved && lastMove.pieceMoved->getType() == PieceType::PAWN) {
             int lastFromRow = lastMove.fromRow;
@@ -128,12 +153,13 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
 
             // Check if last move was a two-step pawn move
             if (std::abs(lastFromRow - lastToRow) == 2) {
-                // If current pawn tries to move diagonally behind that pawn
-                int direction = (pawn->getColor() == PieceColor::WHITE) ? -1 : 1;
-                if (toRow == fromRow + direction &&
+                // If current pawn, standing beside that pawn, moves
+                // diagonally onto the square it skipped
+                if (toRow == fromRow + Traits::pawnDirection &&
                     std::abs(toCol - fromCol) == 1 &&
-                    toRow == lastToRow &&
-                    toCol == lastToCol) {
+                    fromRow == lastToRow &&
+                    toCol == lastToCol &&
+                    !board[toRow][toCol]) {
 
                     isEnPassant = true;
                     enPassantCapturedRow = lastToRow;
@@ -153,38 +179,23 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
 
         // Check rook presence and color
         Piece* rook = board[row][rookCol];
-        if (!rook || rook->getType() != PieceType::ROOK || rook->getColor() != piece->getColor()) {
+        if (!rook || rook->getType() != PieceType::ROOK || rook->getColor() != Us) {
             printMessage("Castling invalid: Rook missing or wrong color.");
             return false;
         }
 
         // Check if king or rook has moved
-        if (piece->getColor() == PieceColor::WHITE) {
-            if (hasWhiteKingMoved) {
-                printMessage("Castling invalid: White king has already moved.");
-                return false;
-            }
-            if (isKingside && hasWhiteKingsideRookMoved) {
-                printMessage("Castling invalid: White kingside rook has already moved.");
-                return false;
-            }
-            if (!isKingside && hasWhiteQueensideRookMoved) {
-                printMessage("Castling invalid: White queenside rook has already moved.");
-                return false;
-            }
-        } else {
-            if (hasBlackKingMoved) {
-                printMessage("Castling invalid: Black king has already moved.");
-                return false;
-            }
-            if (isKingside && hasBlackKingsideRookMoved) {
-                printMessage("Castling invalid: Black kingside rook has already moved.");
-                return false;
-            }
-            if (!isKingside && hasBlackQueensideRookMoved) {
-                printMessage("Castling invalid: Black queenside rook has already moved.");
-                return false;
-            }
+        if (kingMoved) {
+            printMessage(std::string("Castling invalid: ") + side + " king has already moved.");
+            return false;
+        }
+        if (isKingside && kingsideRookMoved) {
+            printMessage(std::string("Castling invalid: ") + side + " kingside rook has already moved.");
+            return false;
+        }
+        if (!isKingside && queensideRookMoved) {
+            printMessage(std::string("Castling invalid: ") + side + " queenside rook has already moved.");
+            return false;
         }
 
         // Check if path between king and rook is clear
@@ -196,7 +207,7 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
         }
 
         // Check if king is currently in check
-        if (isInCheck(piece->getColor())) {
+        if (isInCheck(Us)) {
             printMessage("Castling invalid: King is currently in check.");
             return false;
         }
@@ -210,7 +221,7 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
             board[row][fromCol] = nullptr;
             board[row][c] = origKing;
 
-            if (isInCheck(piece->getColor())) {
+            if (isInCheck(Us)) {
                 board[row][c] = origDest;
                 board[row][fromCol] = origKing;
                 printMessage("Castling invalid: King would pass through check.");
@@ -229,20 +240,16 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
         board[row][rookCol] = nullptr;
 
         // Update castling flags
-        if (piece->getColor() == PieceColor::WHITE) {
-            hasWhiteKingMoved = true;
-            if (isKingside) hasWhiteKingsideRookMoved = true;
-            else hasWhiteQueensideRookMoved = true;
-        } else {
-            hasBlackKingMoved = true;
-            if (isKingside) hasBlackKingsideRookMoved = true;
-            else hasBlackQueensideRookMoved = true;
-        }
+        kingMoved = true;
+        if (isKingside) kingsideRookMoved = true;
+        else queensideRookMoved = true;
 
         lastMove = Move(fromRow, fromCol, toRow, toCol, piece);
 
         printMessage("Castling executed!");
-        currentTurn = (currentTurn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+        currentTurn = Traits::them;
+        refreshHash();
+        recordPosition();
 
         return true;
     }
@@ -256,16 +263,14 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
     Piece* captured = board[toRow][toCol];
 
     if (isEnPassant) {
-        // Remove the captured pawn properly
-        Piece* capturedPawn = board[enPassantCapturedRow][enPassantCapturedCol];
-        if (capturedPawn && capturedPawn->getType() == PieceType::PAWN) {
-            delete capturedPawn;
-            board[enPassantCapturedRow][enPassantCapturedCol] = nullptr;
-            printMessage("En passant captured!");
-        } else {
+        // The captured pawn stands beside the target square. It is only
+        // deleted once the move has proved legal.
+        captured = board[enPassantCapturedRow][enPassantCapturedCol];
+        if (!captured || captured->getType() != PieceType::PAWN) {
             printMessage("En passant capture failed: no pawn to capture.");
             return false;
         }
+        board[enPassantCapturedRow][enPassantCapturedCol] = nullptr;
     }
 
     // Move piece on board
@@ -273,88 +278,94 @@ bool Board::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
     board[fromRow][fromCol] = nullptr;
 
     // Check if move results in own king in check
-    if (isInCheck(piece->getColor())) {
+    if (isInCheck(Us)) {
         // Undo move
         board[fromRow][fromCol] = piece;
-        board[toRow][toCol] = captured;
-
-        Piece* capturedPawn = nullptr;
-
         if (isEnPassant) {
-            // capturedPawn = board[enPassantCapturedRow][enPassantCapturedCol];
-            // if (capturedPawn && capturedPawn->getType() == PieceType::PAWN) {
-            //     delete capturedPawn;
-                board[enPassantCapturedRow][enPassantCapturedCol] = nullptr;
-            // } else {
-            //     printMessage("En passant capture failed: no pawn to capture.");
-            //     return false;
-            // }
+            board[toRow][toCol] = nullptr;
+            board[enPassantCapturedRow][enPassantCapturedCol] = captured;
+        } else {
+            board[toRow][toCol] = captured;
         }
 
         printMessage("Move puts king in check! Invalid.");
         return false;
     }
 
-    // Delete captured piece if any and not en passant (already deleted above)
-    if (captured && !isEnPassant) delete captured;
+    // A rook taken on its home square can no longer castle
+    bool capturedHomeRook = captured && !isEnPassant && toRow == Traits::promotionRow && (toCol == 0 || toCol == 7);
+    if (captured) pieceCount--;
+    delete captured;
+    if (isEnPassant) printMessage("En passant captured!");
 
     // Handle pawn promotion
-    if (piece->getType() == PieceType::PAWN) {
-        if ((piece->getColor() == PieceColor::WHITE && toRow == 0) ||
-            (piece->getColor() == PieceColor::BLACK && toRow == 7)) {
-
-            PieceColor color = piece->getColor();
-            delete piece;
-
-            if (isBotPlaying) {
-                piece = new Queen(color);
-            } else {
-                char choice;
-                std::cout << "Promote pawn to (Q, R, B, N): ";
-                std::cin >> choice;
-                choice = std::toupper(choice);
-
-                switch (choice) {
-                    case 'Q': piece = new Queen(color); break;
-                    case 'R': piece = new Rook(color); break;
-                    case 'B': piece = new Bishop(color); break;
-                    case 'N': piece = new Knight(color); break;
-                    default:
-                        printMessage("Invalid choice. Defaulting to Queen.");
-                        piece = new Queen(color);
-                        break;
-                }
+    if (piece->getType() == PieceType::PAWN && toRow == Traits::promotionRow) {
+        delete piece;
+
+        if (promotion != PieceType::NONE) {
+            switch (promotion) {
+                case PieceType::ROOK: piece = new Rook(Us); break;
+                case PieceType::BISHOP: piece = new Bishop(Us); break;
+                case PieceType::KNIGHT: piece = new Knight(Us); break;
+                default: piece = new Queen(Us); break;
+            }
+        } else if (isBotPlaying) {
+            piece = new Queen(Us);
+        } else {
+            char choice;
+            std::cout << "Promote pawn to (Q, R, B, N): ";
+            std::cin >> choice;
+            choice = std::toupper(choice);
+
+            switch (choice) {
+                case 'Q': piece = new Queen(Us); break;
+                case 'R': piece = new Rook(Us); break;
+                case 'B': piece = new Bishop(Us); break;
+                case 'N': piece = new Knight(Us); break;
+                default:
+                    printMessage("Invalid choice. Defaulting to Queen.");
+                    piece = new Queen(Us);
+                    break;
             }
-
-            board[toRow][toCol] = piece;
         }
+
+        board[toRow][toCol] = piece;
     }
 
     lastMove = Move(fromRow, fromCol, toRow, toCol, piece);
-    recordPosition();
 
     // Update king moved flags if king moved
-    if (piece->getType() == PieceType::KING) {
-        if (piece->getColor() == PieceColor::WHITE) hasWhiteKingMoved = true;
-        else hasBlackKingMoved = true;
-    }
+    if (piece->getType() == PieceType::KING) kingMoved = true;
 
     // Update rook moved flags if rook moved
-    if (piece->getType() == PieceType::ROOK) {
-        if (piece->getColor() == PieceColor::WHITE) {
-            if (fromRow == 7 && fromCol == 0) hasWhiteQueensideRookMoved = true;
-            else if (fromRow == 7 && fromCol == 7) hasWhiteKingsideRookMoved = true;
-        } else {
-            if (fromRow == 0 && fromCol == 0) hasBlackQueensideRookMoved = true;
-            else if (fromRow == 0 && fromCol == 7) hasBlackKingsideRookMoved = true;
-        }
+    if (piece->getType() == PieceType::ROOK && fromRow == Traits::backRank) {
+        if (fromCol == 0) queensideRookMoved = true;
+        else if (fromCol == 7) kingsideRookMoved = true;
     }
+    if (capturedHomeRook)
+        setRookMoved(Traits::them, toCol == 7);
 
-    currentTurn = (currentTurn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+    currentTurn = Traits::them;
+    refreshHash();
+    recordPosition();
 
     return true;
 }
 
+void Board::makeNullMove() {
+    // Update the hash in place instead of refreshHash(): only the side to
+    // move and the en passant square change.
+    if (lastMove.pieceMoved &&
+        lastMove.pieceMoved->getType() == PieceType::PAWN &&
+        std::abs(lastMove.toRow - lastMove.fromRow) == 2) {
+        hashKey ^= Zobrist::enPassantKey(lastMove.toCol);
+    }
+    hashKey ^= Zobrist::sideKey();
+
+    lastMove = Move();
+    currentTurn = (currentTurn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+    halfmoveClock++;
+}
 
 Move Board::getLastMove() const {
     return lastMove;
@@ -389,6 +400,10 @@ bool Board::isInCheck(PieceColor kingColor) const {
         for (int col = 0; col < 8; ++col) {
             Piece* p = board[row][col];
             if (p && p->getColor() != kingColor) {
+                // Only pieces on a line or a knight's jump from the king can
+                // reach it, whatever they are
+                int dr = std::abs(row - kingRow), dc = std::abs(col - kingCol);
+                if (dr != 0 && dc != 0 && dr != dc && dr * dc != 2) continue;
                 if (p->isValidMove(row, col, kingRow, kingCol, const_cast<Piece* (*)[8]>(board))) {
                     return true;
                 }
@@ -432,6 +447,7 @@ Board::Board(const Board& other) : lastMove(other.lastMove), currentTurn(other.c
                 board[r][c] = nullptr;
         }
     }
+    copyStateFrom(other);
 }
 
 
@@ -455,9 +471,38 @@ Board& Board::operator=(const Board& other) {
     }
 
     currentTurn = other.currentTurn;
+    copyStateFrom(other);
     return *this;
 }
 
+// Copies everything but the pieces and the repetition history. Castling
+// rights and the last move feed the hash, so a copy must carry them over.
+void Board::copyStateFrom(const Board& other) {
+    halfmoveClock = other.halfmoveClock;
+    pieceCount = other.pieceCount;
+    hasWhiteKingMoved = other.hasWhiteKingMoved;
+    hasBlackKingMoved = other.hasBlackKingMoved;
+    hasWhiteKingsideRookMoved = other.hasWhiteKingsideRookMoved;
+    hasWhiteQueensideRookMoved = other.hasWhiteQueensideRookMoved;
+    hasBlackKingsideRookMoved = other.hasBlackKingsideRookMoved;
+    hasBlackQueensideRookMoved = other.hasBlackQueensideRookMoved;
+    hashKey = other.hashKey;
+
+    // The moved piece now stands on the destination square; point at our
+    // own copy of it rather than at the other board's piece.
+    lastMove = other.lastMove;
+    if (lastMove.pieceMoved)
+        lastMove.pieceMoved = board[lastMove.toRow][lastMove.toCol];
+}
+
+bool Board::extractEPDPosition(const std::string& line, std::string& position) {
+    std::istringstream ss(line);
+    std::string placement, side, castling, enPassant;
+    if (!(ss >> placement >> side >> castling >> enPassant)) return false;
+    position = placement + " " + side + " " + castling + " " + enPassant;
+    return true;
+}
+
 void Board::loadFEN(const std::string& fen) {
     std::istringstream ss(fen);
     std::string boardPart, activeColor, castling, enPassant;
@@ -471,6 +516,7 @@ void Board::loadFEN(const std::string& fen) {
             delete board[r][c];
             board[r][c] = nullptr;
         }
+    pieceCount = 0;
 
     int row = 0, col = 0;
     for (char ch : boardPart) {
@@ -493,26 +539,43 @@ void Board::loadFEN(const std::string& fen) {
                 case 'k': piece = new King(color); break;
             }
 
+            if (piece) pieceCount++;
             board[row][col++] = piece;
         }
     }
 
     currentTurn = (activeColor == "w") ? PieceColor::WHITE : PieceColor::BLACK;
 
-    hasWhiteKingMoved = castling.find('K') == std::string::npos || castling.find('Q') == std::string::npos;
+    // The rights are kept per rook; the king only counts as moved when both
+    // are gone.
+    hasWhiteKingMoved = castling.find('K') == std::string::npos && castling.find('Q') == std::string::npos;
     hasWhiteKingsideRookMoved = castling.find('K') == std::string::npos;
     hasWhiteQueensideRookMoved = castling.find('Q') == std::string::npos;
-    hasBlackKingMoved = castling.find('k') == std::string::npos || castling.find('q') == std::string::npos;
+    hasBlackKingMoved = castling.find('k') == std::string::npos && castling.find('q') == std::string::npos;
     hasBlackKingsideRookMoved = castling.find('k') == std::string::npos;
     hasBlackQueensideRookMoved = castling.find('q') == std::string::npos;
 
+    // Rebuild the double pawn push behind the en passant square, since that
+    // is how movePiece() and the hash detect en passant.
+    lastMove = Move();
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h') {
+        int epCol = enPassant[0] - 'a';
+        int epRow = '8' - enPassant[1];
+        int fromRow = (epRow == 5) ? 6 : 1;
+        int toRow = (epRow == 5) ? 4 : 3;
+        Piece* pawn = board[toRow][epCol];
+        if (pawn && pawn->getType() == PieceType::PAWN)
+            lastMove = Move(fromRow, epCol, toRow, epCol, pawn);
+    }
+
+    refreshHash();
 }
 
-bool Board::hasKingMoved(PieceColor color) {
+bool Board::hasKingMoved(PieceColor color) const {
     return (color == PieceColor::WHITE) ? hasWhiteKingMoved : hasBlackKingMoved;
 }
 
-bool Board::hasRookMoved(PieceColor color, bool kingside) {
+bool Board::hasRookMoved(PieceColor color, bool kingside) const {
     if (color == PieceColor::WHITE) {
         return kingside ? hasWhiteKingsideRookMoved : hasWhiteQueensideRookMoved;
     } else {
@@ -584,21 +647,19 @@ bool Board::hasLegalMoves(PieceColor color) const {
     return false;
 }
 
+// Positions are told apart by their Zobrist hash, which covers the side to
+// move, castling rights and en passant file. Recording is a push_back, so
+// replaying games stays cheap; the count is only taken when asked for.
 void Board::recordPosition() {
-    std::string key = generatePositionKey();
-    positionHistory[key]++;
+    positionHistory.push_back(hashKey);
 }
 
 bool Board::isThreefoldRepetition() const {
-    std::string key = generatePositionKey();
-    auto it = positionHistory.find(key);
-    return (it != positionHistory.end() && it->second >= 3);
+    return std::count(positionHistory.begin(), positionHistory.end(), hashKey) >= 3;
 }
 
 void Board::resetPositionHistory() {
-    positionHistory.clear();
-    std::string key = generatePositionKey();
-    positionHistory[key] = 1;
+    positionHistory.assign(1, hashKey);
 }
 
 
@@ -658,3 +719,28 @@ std::string Board::generatePositionKey() const {
     return key;
 }
 
+void Board::refreshHash() {
+    uint64_t hash = 0;
+
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            Piece* p = board[r][c];
+            if (p) hash ^= Zobrist::pieceKey(p->getColor(), p->getType(), r, c);
+        }
+    }
+
+    if (!hasWhiteKingMoved && !hasWhiteKingsideRookMoved) hash ^= Zobrist::castlingKey(0);
+    if (!hasWhiteKingMoved && !hasWhiteQueensideRookMoved) hash ^= Zobrist::castlingKey(1);
+    if (!hasBlackKingMoved && !hasBlackKingsideRookMoved) hash ^= Zobrist::castlingKey(2);
+    if (!hasBlackKingMoved && !hasBlackQueensideRookMoved) hash ^= Zobrist::castlingKey(3);
+
+    if (lastMove.pieceMoved &&
+        lastMove.pieceMoved->getType() == PieceType::PAWN &&
+        std::abs(lastMove.toRow - lastMove.fromRow) == 2) {
+        hash ^= Zobrist::enPassantKey(lastMove.toCol);
+    }
+
+    if (currentTurn == PieceColor::BLACK) hash ^= Zobrist::sideKey();
+
+    hashKey = hash;
+}
@@ -5,8 +5,9 @@
 
 #include "piece.h"
 #include "move.h"
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 
 enum class GameResult {
@@ -20,26 +21,35 @@ enum class GameResult {
 class Board {
 
     int halfmoveClock = 0; 
-    std::unordered_map<std::string, int> positionHistory;
+    std::vector<uint64_t> positionHistory;    // Zobrist hash of every position reached
     public:
         Board();
         ~Board();
         void setupBoard();
         void printBoard() const;
-        bool movePiece(int fromRow, int fromCol, int toRow, int toCol);
+        // promotion picks the piece a pawn reaching the last rank becomes.
+        // With NONE the bot promotes to a queen and a human is asked.
+        bool movePiece(int fromRow, int fromCol, int toRow, int toCol, PieceType promotion = PieceType::NONE);
+        // Passes the turn without moving (null move), clearing any en passant
+        // right. Only meant for search; the position is not recorded.
+        void makeNullMove();
         Piece* getPiece(int row, int col) const;
         Piece* const (*getBoard() const)[8];
         Move getLastMove() const;
         bool isInCheck(PieceColor kingColor) const;
         bool isInCheckAfterMove(int fromRow, int fromCol, int toRow, int toCol, PieceColor kingColor) const;
         PieceColor getCurrentTurn() const;
-        void setCurrentTurn(PieceColor color) { currentTurn = color; }
+        void setCurrentTurn(PieceColor color) { currentTurn = color; refreshHash(); }
         Piece* (*getWritableBoard())[8];
         Board(const Board& other);              
         Board& operator=(const Board& other); 
         void loadFEN(const std::string& fen);
-        bool hasKingMoved(PieceColor color);
-        bool hasRookMoved(PieceColor color, bool kingside);
+        // The first four FEN fields of an EPD line or FEN (placement, side,
+        // castling, en passant), dropping clocks and opcodes. loadFEN() needs
+        // the clocks appended. Returns false if a field is missing.
+        static bool extractEPDPosition(const std::string& line, std::string& position);
+        bool hasKingMoved(PieceColor color) const;
+        bool hasRookMoved(PieceColor color, bool kingside) const;
         void setKingMoved(PieceColor color);
         void setRookMoved(PieceColor color, bool kingside);
         bool isValidCastlingMove(int fromRow, int fromCol, int toRow, int toCol, PieceColor color);
@@ -52,6 +62,9 @@ class Board {
         void resetPositionHistory();
         GameResult getGameResult() const;
         std::string generatePositionKey() const;
+        uint64_t getHash() const { return hashKey; }
+        // Pieces on the board, kings included; kept up to date by every move
+        int getPieceCount() const { return pieceCount; }
         bool isBotPlaying = true;
         void printMessage(const std::string& msg);
 
@@ -65,6 +78,12 @@ class Board {
         bool hasBlackKingsideRookMoved = false;
         bool hasBlackQueensideRookMoved = false;
         PieceColor currentTurn;
+        uint64_t hashKey = 0;    // Zobrist hash, refreshed whenever the position changes
+        int pieceCount = 0;
+        void refreshHash();
+        template <PieceColor Us>
+        bool movePieceFor(Piece* piece, int fromRow, int fromCol, int toRow, int toCol, PieceType promotion);
+        void copyStateFrom(const Board& other);
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define MOVE_H
 
 #include "piece.h"
+#include <string>
 
 class Move {
 public:
@@ -10,12 +11,35 @@ public:
     int toRow;
     int toCol;
     Piece* pieceMoved;
+    PieceType promotion;    // piece a pawn promotes to, NONE for other moves
 
     // Default constructor
-    Move() : fromRow(0), fromCol(0), toRow(0), toCol(0), pieceMoved(nullptr) {}
+    Move() : fromRow(0), fromCol(0), toRow(0), toCol(0), pieceMoved(nullptr), promotion(PieceType::NONE) {}
     
-    Move(int fr, int fc, int tr, int tc, Piece* pm)
-        : fromRow(fr), fromCol(fc), toRow(tr), toCol(tc), pieceMoved(pm) {}
+    Move(int fr, int fc, int tr, int tc, Piece* pm, PieceType promo = PieceType::NONE)
+        : fromRow(fr), fromCol(fc), toRow(tr), toCol(tc), pieceMoved(pm), promotion(promo) {}
+
+    bool sameSquares(const Move& other) const {
+        return fromRow == other.fromRow && fromCol == other.fromCol &&
+               toRow == other.toRow && toCol == other.toCol;
+    }
+
+    // Coordinate notation, e.g. "e2e4" or "e7e8q"
+    std::string toString() const {
+        std::string s;
+        s += (char)('a' + fromCol);
+        s += (char)('8' - fromRow);
+        s += (char)('a' + toCol);
+        s += (char)('8' - toRow);
+        switch (promotion) {
+            case PieceType::QUEEN: s += 'q'; break;
+            case PieceType::ROOK: s += 'r'; break;
+            case PieceType::BISHOP: s += 'b'; break;
+            case PieceType::KNIGHT: s += 'n'; break;
+            default: break;
+        }
+        return s;
+    }
 };
 
 #endif
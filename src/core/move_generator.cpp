@@ -2,6 +2,125 @@
 #include <iostream>
 #include <vector>
 
+namespace {
+
+    // Whether color's king is attacked on grid. Works on a bare copy of the
+    // squares so legality can be tested without copying the whole Board.
+    bool isKingAttacked(Piece* grid[8][8], PieceColor color) {
+        int kingRow = -1, kingCol = -1;
+        for (int row = 0; row < 8 && kingRow < 0; ++row) {
+            for (int col = 0; col < 8; ++col) {
+                Piece* p = grid[row][col];
+                if (p && p->getType() == PieceType::KING && p->getColor() == color) {
+                    kingRow = row;
+                    kingCol = col;
+                    break;
+                }
+            }
+        }
+        if (kingRow < 0) return false;
+
+        for (int row = 0; row < 8; ++row) {
+            for (int col = 0; col < 8; ++col) {
+                Piece* p = grid[row][col];
+                if (p && p->getColor() != color && p->isValidMove(row, col, kingRow, kingCol, grid))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // A pawn of colour Us can only end up one or two rows ahead
+    template <PieceColor Us>
+    bool pawnCanReachRow(int fromRow, int toRow) {
+        int ahead = (toRow - fromRow) * ColorTraits<Us>::pawnDirection;
+        return ahead == 1 || ahead == 2;
+    }
+
+    template <PieceColor Us>
+    std::vector<Move> legalMoves(const Board& board) {
+        std::vector<Move> moves;
+        Piece* const (*grid)[8] = board.getBoard();
+
+        for (int fromRow = 0; fromRow < 8; ++fromRow) {
+            for (int fromCol = 0; fromCol < 8; ++fromCol) {
+                Piece* piece = grid[fromRow][fromCol];
+                if (!piece || piece->getColor() != Us) continue;
+
+                bool isPawn = piece->getType() == PieceType::PAWN;
+                for (int toRow = 0; toRow < 8; ++toRow) {
+                    if (isPawn && !pawnCanReachRow<Us>(fromRow, toRow)) continue;
+
+                    for (int toCol = 0; toCol < 8; ++toCol) {
+                        if (fromRow == toRow && fromCol == toCol) continue;
+
+                        if (piece->isValidMove(fromRow, fromCol, toRow, toCol, const_cast<Piece* (*)[8]>(grid))) {
+                            Board temp = board;
+                            if (temp.movePiece(fromRow, fromCol, toRow, toCol) &&
+                                !temp.isInCheck(Us)) {
+                                bool promotes = isPawn && toRow == ColorTraits<Us>::promotionRow;
+                                moves.emplace_back(fromRow, fromCol, toRow, toCol, piece,
+                                           promotes ? PieceType::QUEEN : PieceType::NONE);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return moves;
+    }
+
+    template <PieceColor Us>
+    std::vector<Move> noisyMoves(const Board& board) {
+        std::vector<Move> moves;
+        Piece* grid[8][8];
+        Piece* const (*squares)[8] = board.getBoard();
+        for (int row = 0; row < 8; ++row) {
+            for (int col = 0; col < 8; ++col) grid[row][col] = squares[row][col];
+        }
+
+        constexpr int promotionRow = ColorTraits<Us>::promotionRow;
+
+        auto tryMove = [&](Piece* piece, int fromRow, int fromCol, int toRow, int toCol) {
+            if (!piece->isValidMove(fromRow, fromCol, toRow, toCol, grid)) return;
+
+            Piece* captured = grid[toRow][toCol];
+            grid[toRow][toCol] = piece;
+            grid[fromRow][fromCol] = nullptr;
+            bool legal = !isKingAttacked(grid, Us);
+            grid[fromRow][fromCol] = piece;
+            grid[toRow][toCol] = captured;
+
+            bool promotes = piece->getType() == PieceType::PAWN && toRow == promotionRow;
+            if (legal) moves.emplace_back(fromRow, fromCol, toRow, toCol, piece,
+                                          promotes ? PieceType::QUEEN : PieceType::NONE);
+        };
+
+        for (int fromRow = 0; fromRow < 8; ++fromRow) {
+            for (int fromCol = 0; fromCol < 8; ++fromCol) {
+                Piece* piece = grid[fromRow][fromCol];
+                if (!piece || piece->getColor() != Us) continue;
+
+                bool isPawn = piece->getType() == PieceType::PAWN;
+                for (int toRow = 0; toRow < 8; ++toRow) {
+                    if (isPawn && !pawnCanReachRow<Us>(fromRow, toRow)) continue;
+
+                    for (int toCol = 0; toCol < 8; ++toCol) {
+                        Piece* target = grid[toRow][toCol];
+                        bool capture = target && target->getColor() == ColorTraits<Us>::them && target->getType() != PieceType::KING;
+                        bool promotion = isPawn && !target && toRow == promotionRow && toCol == fromCol;
+                        if (capture || promotion) tryMove(piece, fromRow, fromCol, toRow, toCol);
+                    }
+                }
+            }
+        }
+
+        return moves;
+    }
+
+}
+
 int MoveGenerator::countAllLegalMoves(const Board& board) {
     int count = 0;
     PieceColor currentTurn = board.getCurrentTurn();
@@ -36,29 +155,11 @@ int MoveGenerator::countAllLegalMoves(const Board& board) {
 }
 
 std::vector<Move> MoveGenerator::generateLegalMoves(const Board& board, PieceColor color) {
-    std::vector<Move> legalMoves;
-    Piece* const (*grid)[8] = board.getBoard();
-
-    for (int fromRow = 0; fromRow < 8; ++fromRow) {
-        for (int fromCol = 0; fromCol < 8; ++fromCol) {
-            Piece* piece = grid[fromRow][fromCol];
-            if (!piece || piece->getColor() != color) continue;
-
-            for (int toRow = 0; toRow < 8; ++toRow) {
-                for (int toCol = 0; toCol < 8; ++toCol) {
-                    if (fromRow == toRow && fromCol == toCol) continue;
-
-                    if (piece->isValidMove(fromRow, fromCol, toRow, toCol, const_cast<Piece* (*)[8]>(grid))) {
-                        Board temp = board;
-                        if (temp.movePiece(fromRow, fromCol, toRow, toCol) &&
-                            !temp.isInCheck(color)) {
-                            legalMoves.emplace_back(fromRow, fromCol, toRow, toCol, piece);
-                        }
-                    }
-                }
-            }
-        }
-    }
+    return color == PieceColor::WHITE ? legalMoves<PieceColor::WHITE>(board)
+                                      : legalMoves<PieceColor::BLACK>(board);
+}
 
-    return legalMoves;
+std::vector<Move> MoveGenerator::generateNoisyMoves(const Board& board, PieceColor color) {
+    return color == PieceColor::WHITE ? noisyMoves<PieceColor::WHITE>(board)
+                                      : noisyMoves<PieceColor::BLACK>(board);
 }
@@ -10,6 +10,10 @@ class MoveGenerator {
 public:
     static int countAllLegalMoves(const Board& board);
     std::vector<Move> generateLegalMoves(const Board& board, PieceColor color);
+    // Legal captures and pawn pushes to the last rank (which always promote
+    // to a queen in search). En passant is not generated, as in
+    // generateLegalMoves.
+    std::vector<Move> generateNoisyMoves(const Board& board, PieceColor color);
 };
 
 #endif
@@ -12,22 +12,27 @@ PieceType Pawn::getType() const {
 }
 
 bool Pawn::isValidMove(int fromRow, int fromCol, int toRow, int toCol, Piece* board[8][8]) const {
-    int direction = (color == PieceColor::WHITE) ? -1 : 1;
-    int startRow = (color == PieceColor::WHITE) ? 6 : 1;
+    return color == PieceColor::WHITE ? isValidPawnMove<PieceColor::WHITE>(fromRow, fromCol, toRow, toCol, board)
+                                      : isValidPawnMove<PieceColor::BLACK>(fromRow, fromCol, toRow, toCol, board);
+}
+
+template <PieceColor Us>
+bool Pawn::isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol, Piece* board[8][8]) {
+    constexpr int direction = ColorTraits<Us>::pawnDirection;
 
     int rowDiff = toRow - fromRow;
     int colDiff = toCol - fromCol;
 
     if (colDiff == 0) {
         if (rowDiff == direction && board[toRow][toCol] == nullptr) return true;
-        if (fromRow == startRow && rowDiff == 2 * direction &&
+        if (fromRow == ColorTraits<Us>::pawnStartRow && rowDiff == 2 * direction &&
             board[fromRow + direction][fromCol] == nullptr &&
             board[toRow][toCol] == nullptr) return true;
     }
 
     if (abs(colDiff) == 1 && rowDiff == direction &&
         board[toRow][toCol] != nullptr &&
-        board[toRow][toCol]->getColor() != this->getColor()) {
+        board[toRow][toCol]->getColor() == ColorTraits<Us>::them) {
         return true;
     }
 
@@ -11,4 +11,8 @@ public:
     PieceType getType() const override;
     bool isValidMove(int fromRow, int fromCol, int toRow, int toCol, Piece* board[8][8]) const override;
     bool canEnPassant(int fromRow, int fromCol, int toRow, int toCol, Piece* board[8][8], const Move& lastMove) const;
+
+private:
+    template <PieceColor Us>
+    static bool isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol, Piece* board[8][8]);
 };
@@ -3,6 +3,21 @@
 enum class PieceColor { WHITE, BLACK };
 enum class PieceType { PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING, NONE };
 
+// Colour-dependent constants for code specialised on a side, so they fold
+// away at compile time. Row 0 is rank 8.
+template <PieceColor Us>
+struct ColorTraits {
+    static constexpr bool white = Us == PieceColor::WHITE;
+    static constexpr PieceColor them = white ? PieceColor::BLACK : PieceColor::WHITE;
+    static constexpr int sign = white ? 1 : -1;             // evaluation is from white's side
+    static constexpr int pawnDirection = white ? -1 : 1;
+    static constexpr int pawnStartRow = white ? 6 : 1;
+    static constexpr int backRank = white ? 7 : 0;
+    static constexpr int promotionRow = white ? 0 : 7;
+    // Row as seen from white, for the piece-square tables
+    static constexpr int relativeRow(int row) { return white ? row : 7 - row; }
+};
+
 class Piece {
 protected:
     PieceColor color;
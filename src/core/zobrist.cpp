@@ -0,0 +1,64 @@
+#include "zobrist.h"
+#include <cstddef>
+
+namespace {
+
+    struct ZobristKeys {
+        uint64_t pieces[2][6][64];
+        uint64_t castling[4];
+        uint64_t enPassant[8];
+        uint64_t side;
+
+        ZobristKeys() {
+            // splitmix64
+            uint64_t state = 0x5049585943484553ULL;
+            auto next = [&state]() {
+                uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                return z ^ (z >> 31);
+            };
+
+            for (auto& color : pieces)
+                for (auto& type : color)
+                    for (auto& square : type)
+                        square = next();
+            for (auto& key : castling) key = next();
+            for (auto& key : enPassant) key = next();
+            side = next();
+        }
+    };
+
+    const ZobristKeys& keys() {
+        static const ZobristKeys instance;
+        return instance;
+    }
+
+}
+
+uint64_t Zobrist::pieceKey(PieceColor color, PieceType type, int row, int col) {
+    return keys().pieces[(int)color][(int)type][row * 8 + col];
+}
+
+uint64_t Zobrist::castlingKey(int right) {
+    return keys().castling[right];
+}
+
+uint64_t Zobrist::enPassantKey(int col) {
+    return keys().enPassant[col];
+}
+
+uint64_t Zobrist::sideKey() {
+    return keys().side;
+}
+
+uint64_t Zobrist::fingerprint() {
+    const ZobristKeys& k = keys();
+    const uint64_t* data = &k.pieces[0][0][0];
+    size_t count = sizeof(ZobristKeys) / sizeof(uint64_t);
+    uint64_t hash = 0;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "piece.h"
+#include <cstdint>
+
+// Zobrist keys for position hashing. Keys are generated from a fixed seed, so
+// hashes are stable across runs and processes.
+namespace Zobrist {
+    uint64_t pieceKey(PieceColor color, PieceType type, int row, int col);
+    uint64_t castlingKey(int right);    // 0 = K, 1 = Q, 2 = k, 3 = q
+    uint64_t enPassantKey(int col);
+    uint64_t sideKey();                 // XORed in when black is to move
+
+    // Hash of every key, to tell whether stored hashes (e.g. a saved
+    // transposition table) were made with the same keys.
+    uint64_t fingerprint();
+}
+
+#endif
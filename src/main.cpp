@@ -1,11 +1,23 @@
 #include "core/board.h"
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <cctype>
 #include "core/move_generator.h"
 #include <fstream>
 #include <sstream>
+#include <thread>
 #include "ai/bot.h"
+#include "ai/bench.h"
+#include "ai/batch_analysis.h"
+#include "ai/pgn.h"
+#include "ai/polyglot.h"
+#include "ai/syzygy.h"
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 
 // Function to test loading FEN from a file
 void testFENLoading(const std::string& filename) {
@@ -63,9 +75,114 @@ bool parseMove(const std::string& input, int& fromRow, int& fromCol, int& toRow,
     return true;
 }
 
+void printSearchProgress(const SearchInfo& info) {
+    std::cout << "Depth " << info.depth << " completed. Best score: ";
+    if (info.mateIn != 0) std::cout << "mate " << info.mateIn;
+    else std::cout << info.score;
+    std::cout << ", nodes: " << info.nodes << ", nps: " << info.nps << ", PV:";
+    for (const auto& move : info.pv) std::cout << " " << move.toString();
+    std::cout << std::endl;
+}
+
+// pixy analyze <file.epd> [--depth N] [--nodes N] [--movetime MS] [--jobs N] [--hash MB] [--output FILE]
+int runAnalyzeCommand(int argc, char* argv[]) {
+    const char* usage = "Usage: pixy analyze <file.epd> [--depth N] [--nodes N] [--movetime MS] [--jobs N] [--hash MB] [--output FILE]\n";
+    if (argc < 3) {
+        std::cout << usage;
+        return 1;
+    }
+
+    BatchOptions options;
+    std::string outputPath;
+    try {
+        for (int i = 3; i < argc; i += 2) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) throw std::invalid_argument(arg);
+            std::string value = argv[i + 1];
+            if (arg == "--depth") options.limits.depth = std::stoi(value);
+            else if (arg == "--nodes") options.limits.nodes = std::stoull(value);
+            else if (arg == "--movetime") options.limits.moveTime = std::stoi(value);
+            else if (arg == "--jobs") options.jobs = std::stoi(value);
+            else if (arg == "--hash") options.hashMB = std::stoul(value);
+            else if (arg == "--output") outputPath = value;
+            else throw std::invalid_argument(arg);
+        }
+    } catch (const std::exception&) {
+        std::cout << usage;
+        return 1;
+    }
+    if (options.limits.depth == 0 && options.limits.nodes == 0 && options.limits.moveTime == 0)
+        options.limits.depth = 6;
+
+    std::ifstream input(argv[2]);
+    if (!input) {
+        std::cout << "Error opening " << argv[2] << "\n";
+        return 1;
+    }
+    std::ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (!outputFile) {
+            std::cout << "Error opening " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    BatchSummary summary = analyzeBatch(input, outputPath.empty() ? std::cout : outputFile, options);
+    std::cerr << "Analysed " << summary.positions << " positions (" << summary.errors << " errors) in "
+              << summary.timeMs << " ms, " << summary.nodes << " nodes, "
+              << summary.positions * 1000 / std::max<int64_t>(1, summary.timeMs) << " positions/s" << std::endl;
+    return 0;
+}
+
+// pixy pgn <file.pgn> [--jobs N]
+// Replays every game of a PGN file and reports the games that fail.
+int runPgnCommand(int argc, char* argv[]) {
+    const char* usage = "Usage: pixy pgn <file.pgn> [--jobs N]\n";
+    int jobs = 1;
+    try {
+        if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--jobs")) throw std::invalid_argument("");
+        if (argc == 5) jobs = std::stoi(argv[4]);
+    } catch (const std::exception&) {
+        std::cout << usage;
+        return 1;
+    }
+
+    std::unique_ptr<PgnReader> reader;
+    try {
+        reader = std::make_unique<PgnReader>(argv[2]);
+    } catch (const std::exception& e) {
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+
+    std::mutex outputMutex;
+    PgnCallbacks callbacks;
+    callbacks.end = [&](const PgnGame& game, const Board&, const std::string& error) {
+        if (error.empty()) return;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "Game at byte " << game.offset << ": " << error << "\n";
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    PgnSummary summary = reader->read(callbacks, jobs);
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Read " << summary.games << " games, " << summary.moves << " moves (" << summary.errors
+              << " errors) in " << ms << " ms, " << summary.games * 60000 / std::max<int64_t>(1, ms)
+              << " games/min" << std::endl;
+    return summary.errors == 0 ? 0 : 1;
+}
+
+// Set from --book / --book-keys on the command line
+std::shared_ptr<const PolyglotBook> openingBook;
+
 void playVsComputer(bool playerIsWhite) {
     Board board;
     Bot bot;
+    bot.setBook(openingBook);
+    bot.setThreads(std::thread::hardware_concurrency());
+    bot.setProgressCallback(printSearchProgress);
     std::string input;
     
     board.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
@@ -104,6 +221,9 @@ void playVsComputer(bool playerIsWhite) {
                     std::cout << "Invalid move. Try again.\n";
                     continue;
                 }
+                // A ponder search on another reply is useless now
+                if (bot.isPondering() && !bot.getPonderingMove().sameSquares(Move(fr, fc, tr, tc, nullptr)))
+                    bot.stopPondering();
             } else {
                 std::cout << "Invalid input format. Use format like 'e2 e4'.\n";
                 continue;
@@ -112,19 +232,26 @@ void playVsComputer(bool playerIsWhite) {
             std::cout << "Computer is thinking...\n";
             board.isBotPlaying = true;
             try {
-                // Adaptive depth based on game phase
-                int searchDepth = 4;
-                int totalPieces = 0;
-                for (int r = 0; r < 8; r++) {
-                    for (int c = 0; c < 8; c++) {
-                        if (board.getPiece(r, c)) totalPieces++;
-                    }
+                SearchLimits limits = SearchLimits::fixedTime(SearchLimits::DEFAULT_MOVE_TIME_MS);
+                // Still pondering means the player made the expected move
+                Move bestMove;
+                if (bot.isPondering()) {
+                    bot.ponderHit();
+                    bestMove = bot.wait();
+                } else {
+                    bestMove = bot.findBestMove(board, limits);
                 }
-                if (totalPieces > 28) searchDepth = 3; // Opening: faster play
-                else if (totalPieces < 12) searchDepth = 5; // Endgame: deeper search
-                
-                Move bestMove = bot.findBestMove(board, searchDepth);
+                if (bot.getMoveSource() == MoveSource::BOOK)
+                    std::cout << "Book move" << std::endl;
+                else if (bot.getMoveSource() == MoveSource::ENDGAME_TABLES)
+                    std::cout << "Endgame table move" << std::endl;
+                else
+                    bot.getSearchStats().print(std::cout);
+                Move expectedReply = bot.getPonderMove(board);
                 board.movePiece(bestMove.fromRow, bestMove.fromCol, bestMove.toRow, bestMove.toCol);
+
+                // Think on the player's time about the reply we expect
+                bot.startPondering(board, expectedReply, limits);
             } catch (const std::exception& e) {
                 std::cout << "Computer failed to find move: " << e.what() << '\n';
                 break;
@@ -136,7 +263,84 @@ void playVsComputer(bool playerIsWhite) {
     }
 }
 
-int main() {
+// pixy bench [depth] [threads] [hashMB] [--json FILE]
+int runBenchCommand(int argc, char* argv[]) {
+    const char* usage = "Usage: pixy bench [depth] [threads] [hashMB] [--json FILE]\n";
+    int depth = 5, threads = 1;
+    size_t hashMB = 16;
+    std::string jsonPath;
+    try {
+        std::vector<std::string> values;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--json") {
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                jsonPath = argv[++i];
+            } else {
+                values.push_back(arg);
+            }
+        }
+        if (values.size() > 3) throw std::invalid_argument(values.back());
+        if (values.size() > 0) depth = std::stoi(values[0]);
+        if (values.size() > 1) threads = std::stoi(values[1]);
+        if (values.size() > 2) hashMB = std::stoul(values[2]);
+    } catch (const std::exception&) {
+        std::cout << usage;
+        return 1;
+    }
+
+    std::ofstream json;
+    if (!jsonPath.empty()) {
+        json.open(jsonPath);
+        if (!json) {
+            std::cout << "Error opening " << jsonPath << "\n";
+            return 1;
+        }
+    }
+    runBench(depth, threads, hashMB, std::cout, jsonPath.empty() ? nullptr : &json);
+    return 0;
+}
+
+// pixy [--book FILE.bin [--book-keys FILE]] [--syzygy PATH]
+bool parseOptions(int argc, char* argv[]) {
+    std::string bookPath, keysPath, syzygyPath;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--book") bookPath = argv[i + 1];
+        else if (arg == "--book-keys") keysPath = argv[i + 1];
+        else if (arg == "--syzygy") syzygyPath = argv[i + 1];
+        else {
+            std::cout << "Usage: pixy [--book FILE.bin [--book-keys FILE]] [--syzygy PATH] | pixy bench [depth] [threads] [hashMB] [--json FILE]\n";
+            return false;
+        }
+    }
+    if (!syzygyPath.empty())
+        std::cout << "Syzygy: " << Syzygy::init(syzygyPath) << " tables, up to " << Syzygy::maxPieces() << " pieces\n";
+    if (bookPath.empty())
+        return true;
+
+    try {
+        if (!keysPath.empty())
+            PolyglotBook::loadKeys(keysPath);
+        openingBook = std::make_shared<PolyglotBook>(bookPath);
+        std::cout << "Opening book: " << openingBook->size() << " entries\n";
+    } catch (const std::exception& e) {
+        std::cout << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench")
+        return runBenchCommand(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "analyze")
+        return runAnalyzeCommand(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "pgn")
+        return runPgnCommand(argc, argv);
+    if (!parseOptions(argc, argv))
+        return 1;
+
     while (true) {
         std::cout << "+--------------------------------+\n";
         std::cout << "|        ** PIXY CHESS **        |\n";
@@ -0,0 +1,149 @@
+#include "ai/match.h"
+#include "ai/tuner.h"
+#include "core/board.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void printUsage() {
+    std::cout << "Usage: pixy-match --engine [KEY=VALUE...] --engine [KEY=VALUE...] [options]\n";
+    std::cout << "  engine keys: name=NAME params=FILE hash=MB threads=N tables=on|off\n";
+    std::cout << "               rfp= futility= razor= see= seequiet= (margins for depths 1-3, e.g. 90,180,270)\n";
+    std::cout << "  --games N          games to play (default 100)\n";
+    std::cout << "  --concurrency N    games played at once (default: one per core)\n";
+    std::cout << "  --openings FILE    FEN/EPD lines, each played with both colours\n";
+    std::cout << "  --nodes N          fixed nodes per move\n";
+    std::cout << "  --tc BASE+INC      clock in seconds, e.g. 10+0.1 (default)\n";
+    std::cout << "  --max-plies N      adjudicate longer games as draws (default 400)\n";
+    std::cout << "  --sprt [elo0=X elo1=X alpha=X beta=X]   stop early by SPRT (default 0, 5, 0.05, 0.05)\n";
+}
+
+// Splits "key=value"; throws std::invalid_argument on anything else
+void splitOption(const std::string& arg, std::string& key, std::string& value) {
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos) throw std::invalid_argument(arg);
+    key = arg.substr(0, equals);
+    value = arg.substr(equals + 1);
+}
+
+// One comma-separated margin per depth, e.g. "90,180,270"
+void parseMargins(const std::string& value, int (&margins)[PruningMargins::MAX_DEPTH + 1]) {
+    std::istringstream ss(value);
+    std::string item;
+    int depth = 1;
+    for (; depth <= PruningMargins::MAX_DEPTH && std::getline(ss, item, ','); depth++)
+        margins[depth] = std::stoi(item);
+    if (depth <= PruningMargins::MAX_DEPTH || std::getline(ss, item, ','))
+        throw std::invalid_argument(value);
+}
+
+void parseEngineOption(const std::string& arg, EngineConfig& config) {
+    std::string key, value;
+    splitOption(arg, key, value);
+    PruningMargins& margins = config.pruningMargins;
+    if (key == "name") config.name = value;
+    else if (key == "rfp") parseMargins(value, margins.reverseFutility);
+    else if (key == "futility") parseMargins(value, margins.futility);
+    else if (key == "razor") parseMargins(value, margins.razoring);
+    else if (key == "see") parseMargins(value, margins.seeCapture);
+    else if (key == "seequiet") parseMargins(value, margins.seeQuiet);
+    else if (key == "hash") config.hashMB = std::stoul(value);
+    else if (key == "threads") config.threads = std::stoi(value);
+    else if (key == "tables") config.endgameTables = value == "on";
+    else if (key == "params") {
+        std::ifstream file(value);
+        if (!file || !Tuner::readParams(file, config.evalParams))
+            throw std::runtime_error("Cannot read evaluation parameters from " + value);
+    }
+    else throw std::invalid_argument(arg);
+}
+
+void parseSprtOption(const std::string& arg, SprtOptions& sprt) {
+    std::string key, value;
+    splitOption(arg, key, value);
+    if (key == "elo0") sprt.elo0 = std::stod(value);
+    else if (key == "elo1") sprt.elo1 = std::stod(value);
+    else if (key == "alpha") sprt.alpha = std::stod(value);
+    else if (key == "beta") sprt.beta = std::stod(value);
+    else throw std::invalid_argument(arg);
+}
+
+// Seconds with an optional "+increment", e.g. "60+0.5"
+void parseTimeControl(const std::string& value, TimeControl& control) {
+    size_t plus = value.find('+');
+    control.baseMs = (int)(std::stod(value.substr(0, plus)) * 1000);
+    control.incrementMs = plus == std::string::npos ? 0 : (int)(std::stod(value.substr(plus + 1)) * 1000);
+}
+
+// FEN/EPD lines; EPD lines lack the clock fields
+std::vector<std::string> readOpenings(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+
+    std::vector<std::string> openings;
+    std::string line, position;
+    size_t skipped = 0;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (Board::extractEPDPosition(line, position)) openings.push_back(position + " 0 1");
+        else skipped++;
+    }
+    if (skipped > 0) std::cerr << "Skipped " << skipped << " unreadable openings in " << path << std::endl;
+    if (openings.empty()) throw std::runtime_error("No openings in " + path);
+    return openings;
+}
+
+int main(int argc, char* argv[]) {
+    MatchOptions options;
+    options.timeControl.baseMs = 10000;
+    options.timeControl.incrementMs = 100;
+    int engineCount = 0;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            // Options taking a list of KEY=VALUE arguments
+            if (arg == "--engine" || arg == "--sprt") {
+                if (arg == "--engine" && engineCount == 2) throw std::invalid_argument(arg);
+                if (arg == "--sprt") options.sprt.enabled = true;
+                EngineConfig& config = options.engines[arg == "--engine" ? engineCount++ : 0];
+                for (; i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0; i++) {
+                    if (arg == "--engine") parseEngineOption(argv[i + 1], config);
+                    else parseSprtOption(argv[i + 1], options.sprt);
+                }
+                continue;
+            }
+
+            if (i + 1 >= argc) throw std::invalid_argument(arg);
+            std::string value = argv[++i];
+            if (arg == "--games") options.games = std::stoi(value);
+            else if (arg == "--concurrency") options.concurrency = std::stoi(value);
+            else if (arg == "--openings") options.openings = readOpenings(value);
+            else if (arg == "--nodes") options.timeControl.nodes = std::stoull(value);
+            else if (arg == "--tc") parseTimeControl(value, options.timeControl);
+            else if (arg == "--max-plies") options.maxPlies = std::stoi(value);
+            else throw std::invalid_argument(arg);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+    if (engineCount != 2) {
+        printUsage();
+        return 1;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (options.engines[i].name.empty()) options.engines[i].name = "engine" + std::to_string(i + 1);
+    }
+
+    Match match(options);
+    MatchResult result = match.run(std::cout);
+    return result.score.games() > 0 ? 0 : 1;
+}
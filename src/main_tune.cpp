@@ -0,0 +1,51 @@
+#include "ai/tuner.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+void printUsage() {
+    std::cout << "Usage: pixy-tune <dataset> [--epochs N] [--threads N] [--lr X] [--k X] [--output FILE]\n";
+    std::cout << "  dataset lines: <fen> followed by 1-0 / 0-1 / 1/2-1/2 or [1.0] / [0.5] / [0.0]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string datasetPath = argv[1];
+    std::string outputPath;
+    TunerOptions options;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--epochs") options.epochs = std::stoi(value);
+        else if (arg == "--threads") options.threads = std::stoi(value);
+        else if (arg == "--lr") options.learningRate = std::stod(value);
+        else if (arg == "--k") options.scalingK = std::stod(value);
+        else if (arg == "--output") outputPath = value;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    Tuner tuner(options);
+    if (!tuner.loadDataset(datasetPath)) return 1;
+    tuner.run();
+
+    if (outputPath.empty()) {
+        Tuner::printParams(std::cout, tuner.getParams());
+    } else {
+        std::ofstream out(outputPath);
+        Tuner::printParams(out, tuner.getParams());
+        std::cout << "Tuned parameters written to " << outputPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include "core/board.h"
+#include "ai/bot.h"
+#include "ai/endgame_tables.h"
+#include "ai/syzygy.h"
+#include <condition_variable>
+#include <memory>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// UCI front end. Searches run on the bot's background thread and a waiter
+// thread reports their result, so this thread keeps reading stdin and stop
+// or ponderhit take effect at once.
+class UciEngine {
+public:
+    UciEngine() {
+        bot.setProgressCallback([this](const SearchInfo& info) { sendInfo(info); });
+        // Tables are on by default; build them while the GUI sets up
+        EndgameTables::prepare();
+        board.loadFEN(START_FEN);
+    }
+
+    ~UciEngine() {
+        stopSearch();
+    }
+
+    void run() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::istringstream ss(line);
+            std::string command;
+            ss >> command;
+
+            if (command == "uci") {
+                send("id name Pixy");
+                send("id author Shubham Kashyap");
+                send("option name Hash type spin default 16 min 1 max 65536");
+                send("option name Threads type spin default 1 min 1 max 256");
+                send("option name MultiPV type spin default 1 min 1 max 256");
+                send("option name Ponder type check default false");
+                send("option name Clear Hash type button");
+                send("option name Hash File type string default <empty>");
+                send("option name Save Hash type button");
+                send("option name Load Hash type button");
+                send("option name Map Hash type button");
+                send("option name Endgame Tables type check default true");
+                send("option name SyzygyPath type string default <empty>");
+                send("option name SyzygyProbeLimit type spin default 7 min 0 max 7");
+                send("option name Book Keys type string default <empty>");
+                send("option name Book File type string default <empty>");
+                send("uciok");
+            } else if (command == "isready") {
+                send("readyok");
+            } else if (command == "ucinewgame") {
+                stopSearch();
+                bot.newGame();
+                board.loadFEN(START_FEN);
+            } else if (command == "position") {
+                stopSearch();
+                handlePosition(ss);
+            } else if (command == "go") {
+                stopSearch();
+                handleGo(ss);
+            } else if (command == "stop") {
+                stopSearch();
+            } else if (command == "ponderhit") {
+                bot.ponderHit();
+                {
+                    std::lock_guard<std::mutex> lock(holdMutex);
+                    holdBestMove = infiniteSearch;
+                }
+                holdCondition.notify_all();
+            } else if (command == "setoption") {
+                stopSearch();
+                handleSetOption(ss);
+            } else if (command == "quit") {
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::endl;
+    }
+
+    void sendInfo(const SearchInfo& info) {
+        std::ostringstream out;
+        out << "info depth " << info.depth << " multipv " << info.multiPV << " score ";
+        if (info.mateIn != 0) out << "mate " << info.mateIn;
+        else out << "cp " << info.score;
+        out << " nodes " << info.nodes << " nps " << info.nps << " time " << info.timeMs
+            << " hashfull " << info.hashfull << " pv";
+        for (const auto& move : info.pv) out << " " << move.toString();
+        send(out.str());
+    }
+
+    // position [startpos | fen <fen>] [moves <move> ...]
+    void handlePosition(std::istringstream& ss) {
+        std::string token;
+        ss >> token;
+        if (token == "startpos") {
+            board.loadFEN(START_FEN);
+            ss >> token;
+        } else if (token == "fen") {
+            std::vector<std::string> fields;
+            while (ss >> token && token != "moves") fields.push_back(token);
+            if (fields.size() < 4) return;
+
+            // The move counters are optional in UCI
+            if (fields.size() < 5) fields.push_back("0");
+            if (fields.size() < 6) fields.push_back("1");
+            std::string fen;
+            for (const auto& field : fields) fen += field + " ";
+            board.loadFEN(fen);
+        } else {
+            return;
+        }
+
+        if (token != "moves") return;
+        while (ss >> token) {
+            Move move;
+            if (!parseMove(token, move) ||
+                !board.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion)) {
+                send("info string illegal move " + token);
+                return;
+            }
+        }
+    }
+
+    // Coordinate notation: e2e4, e1g1 (castling), e7e8q
+    static bool parseMove(const std::string& text, Move& move) {
+        if (text.size() < 4 || text.size() > 5) return false;
+        if (text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8' ||
+            text[2] < 'a' || text[2] > 'h' || text[3] < '1' || text[3] > '8') return false;
+
+        PieceType promotion = PieceType::NONE;
+        if (text.size() == 5) {
+            switch (text[4]) {
+                case 'q': promotion = PieceType::QUEEN; break;
+                case 'r': promotion = PieceType::ROOK; break;
+                case 'b': promotion = PieceType::BISHOP; break;
+                case 'n': promotion = PieceType::KNIGHT; break;
+                default: return false;
+            }
+        }
+        move = Move('8' - text[1], text[0] - 'a', '8' - text[3], text[2] - 'a', nullptr, promotion);
+        return true;
+    }
+
+    void handleGo(std::istringstream& ss) {
+        SearchLimits limits;
+        std::string token;
+        while (ss >> token) {
+            if (token == "wtime") ss >> limits.whiteTime;
+            else if (token == "btime") ss >> limits.blackTime;
+            else if (token == "winc") ss >> limits.whiteIncrement;
+            else if (token == "binc") ss >> limits.blackIncrement;
+            else if (token == "movestogo") ss >> limits.movesToGo;
+            else if (token == "movetime") ss >> limits.moveTime;
+            else if (token == "nodes") ss >> limits.nodes;
+            else if (token == "depth") ss >> limits.depth;
+            else if (token == "infinite") limits.infinite = true;
+            else if (token == "ponder") limits.ponder = true;
+        }
+
+        // In infinite and ponder mode bestmove must wait for stop (or
+        // ponderhit), even if the search ends by itself.
+        infiniteSearch = limits.infinite;
+        holdBestMove = limits.infinite || limits.ponder;
+
+        bot.start(board, limits);
+        waiter = std::thread([this] {
+            std::string result = "bestmove 0000";
+            try {
+                Move best = bot.wait();
+                result = "bestmove " + best.toString();
+                Move reply = bot.getPonderMove(board);
+                if (reply.fromRow != reply.toRow || reply.fromCol != reply.toCol)
+                    result += " ponder " + reply.toString();
+            } catch (const std::exception& e) {
+                send(std::string("info string ") + e.what());
+            }
+
+            std::unique_lock<std::mutex> lock(holdMutex);
+            holdCondition.wait(lock, [this] { return !holdBestMove; });
+            send(result);
+        });
+    }
+
+    void stopSearch() {
+        if (!waiter.joinable()) return;
+
+        bot.stop();
+        {
+            std::lock_guard<std::mutex> lock(holdMutex);
+            holdBestMove = false;
+        }
+        holdCondition.notify_all();
+        waiter.join();
+    }
+
+    // setoption name <name> [value <value>]
+    void handleSetOption(std::istringstream& ss) {
+        std::string token, name, value;
+        ss >> token;
+        while (ss >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+        std::getline(ss >> std::ws, value);
+
+        try {
+            if (name == "Hash") bot.setHashSize(std::stoul(value));
+            else if (name == "Threads") bot.setThreads(std::stoi(value));
+            else if (name == "MultiPV") bot.setMultiPV(std::stoi(value));
+            else if (name == "Clear Hash") bot.clearHash();
+            else if (name == "Hash File") hashFile = value == "<empty>" ? "" : value;
+            else if (name == "Save Hash" || name == "Load Hash" || name == "Map Hash") {
+                if (hashFile.empty()) send("info string Hash File is not set");
+                else if (name == "Save Hash") bot.saveHash(hashFile);
+                else if (name == "Load Hash") bot.loadHash(hashFile);
+                else bot.mapHash(hashFile, bot.getHashSize());
+            }
+            else if (name == "Endgame Tables") {
+                bot.setEndgameTables(value == "true");
+                if (value == "true") EndgameTables::prepare();
+            }
+            else if (name == "SyzygyPath")
+                send("info string found " + std::to_string(Syzygy::init(value)) + " Syzygy tables");
+            else if (name == "SyzygyProbeLimit") bot.setSyzygyProbeLimit(std::stoi(value));
+            else if (name == "Book Keys" || name == "Book File") {
+                // Book Keys replaces the built-in key table
+                bool empty = value.empty() || value == "<empty>";
+                if (name == "Book Keys" && !empty) PolyglotBook::loadKeys(value);
+                else if (name == "Book File") bot.setBook(empty ? nullptr : std::make_shared<PolyglotBook>(value));
+            }
+        } catch (const std::invalid_argument&) {
+            send("info string invalid value for " + name);
+        } catch (const std::exception& e) {
+            send(std::string("info string ") + e.what());
+        }
+    }
+
+    Board board;
+    Bot bot;
+    std::string hashFile;
+    std::thread waiter;
+    std::mutex outputMutex;
+
+    std::mutex holdMutex;
+    std::condition_variable holdCondition;
+    bool holdBestMove = false;
+    bool infiniteSearch = false;
+};
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    // Reading stdin would otherwise flush stdout from this thread, outside
+    // outputMutex, racing the waiter's bestmove. send() flushes every line.
+    std::cin.tie(nullptr);
+    UciEngine engine;
+    engine.run();
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 class ChessGame {
 private:
@@ -19,6 +20,12 @@ private:
     
 public:
     ChessGame() : vsComputer(true), whiteIsHuman(true) {
+        bot.setThreads(std::thread::hardware_concurrency());
+        bot.setProgressCallback([](const SearchInfo& info) {
+            std::string pv;
+            for (const auto& move : info.pv) pv += move.toString() + " ";
+            ChessUI::displaySearchProgress(info.depth, info.score, info.mateIn, info.nodes, info.nps, pv);
+        });
         board.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
     }
     
@@ -45,6 +52,9 @@ public:
                     showSettings();
                     break;
                 case 5:
+                    analyzePosition();
+                    break;
+                case 6:
                     std::cout << "\nThanks for playing Pixy Chess! 👋\n";
                     return;
             }
@@ -89,6 +99,7 @@ private:
             
             GameResult result = board.getGameResult();
             if (result != GameResult::Ongoing) {
+                bot.stopPondering();
                 ChessUI::displayGameResult(result, board.getCurrentTurn());
                 std::cout << "\nPress Enter to return to menu...";
                 std::cin.get();
@@ -101,6 +112,7 @@ private:
             
             if (isHumanTurn) {
                 if (!handleHumanMove()) {
+                    bot.stopPondering();
                     return; // Player quit
                 }
             } else {
@@ -127,6 +139,10 @@ private:
         if (parseMove(input, fromRow, fromCol, toRow, toCol)) {
             if (board.movePiece(fromRow, fromCol, toRow, toCol)) {
                 moveHistory.push_back(input);
+                // A ponder search on another reply is useless now
+                if (bot.isPondering() &&
+                    !bot.getPonderingMove().sameSquares(Move(fromRow, fromCol, toRow, toCol, nullptr)))
+                    bot.stopPondering();
                 return true;
             } else {
                 std::cout << "❌ Invalid move! Try again.\n";
@@ -142,16 +158,26 @@ private:
         ChessUI::displayThinking();
         
         try {
-            // Adaptive depth based on game phase
-            int searchDepth = calculateSearchDepth();
-            
-            Move bestMove = bot.findBestMove(board, searchDepth);
+            SearchLimits limits = SearchLimits::fixedTime(SearchLimits::DEFAULT_MOVE_TIME_MS);
+            // Still pondering means the player made the expected move
+            Move bestMove;
+            if (bot.isPondering()) {
+                bot.ponderHit();
+                bestMove = bot.wait();
+            } else {
+                bestMove = bot.findBestMove(board, limits);
+            }
+            bot.getSearchStats().print(std::cout);
+            Move expectedReply = bot.getPonderMove(board);
             
             // Convert move to string for history
             std::string moveStr = moveToString(bestMove);
             moveHistory.push_back(moveStr);
             
             board.movePiece(bestMove.fromRow, bestMove.fromCol, bestMove.toRow, bestMove.toCol);
+
+            // Think on the player's time about the reply we expect
+            bot.startPondering(board, expectedReply, limits);
             
             std::cout << "🤖 Bot played: " << moveStr << "\n";
             std::cout << "Press Enter to continue...";
@@ -164,19 +190,6 @@ private:
         }
     }
     
-    int calculateSearchDepth() {
-        int totalPieces = 0;
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                if (board.getPiece(r, c)) totalPieces++;
-            }
-        }
-        
-        if (totalPieces > 28) return 3;      // Opening
-        else if (totalPieces > 16) return 4; // Middlegame  
-        else return 5;                       // Endgame
-    }
-    
     std::string moveToString(const Move& move) {
         char fromFile = 'a' + move.fromCol;
         char fromRank = '8' - move.fromRow;
@@ -231,12 +244,38 @@ private:
         }
     }
     
+    // Infinite analysis of the current position on a background search,
+    // until the user presses Enter.
+    void analyzePosition() {
+        ChessUI::clearScreen();
+        ChessUI::displayBoard(board);
+        std::cout << "\n🔍 Analyzing... press Enter to stop.\n\n";
+
+        SearchLimits limits;
+        limits.infinite = true;
+        bot.start(board, limits);
+
+        std::string line;
+        std::getline(std::cin, line);
+        bot.stop();
+
+        try {
+            Move bestMove = bot.wait();
+            std::cout << "\nBest move: " << moveToString(bestMove) << "\n";
+        } catch (const std::exception& e) {
+            std::cout << "❌ Analysis failed: " << e.what() << "\n";
+        }
+        std::cout << "Press Enter to continue...";
+        std::cin.get();
+    }
+
     void showSettings() {
         ChessUI::clearScreen();
         std::cout << "\n⚙️  Settings\n";
-        std::cout << "1. Bot difficulty: Adaptive (3-5 depth)\n";
+        std::cout << "1. Bot difficulty: " << SearchLimits::DEFAULT_MOVE_TIME_MS / 1000 << " seconds per move\n";
         std::cout << "2. UI style: Unicode chess pieces\n";
         std::cout << "3. Features: Move history, game analysis\n";
+        std::cout << "4. Search threads: " << bot.getThreads() << "\n";
         std::cout << "\nPress Enter to return...";
         std::cin.get();
     }
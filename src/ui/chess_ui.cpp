@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cctype>
+#include <sstream>
 
 void ChessUI::displayMainMenu() {
     clearScreen();
@@ -14,16 +15,17 @@ void ChessUI::displayMainMenu() {
     std::cout << "║  2. Two Player Game                  ║\n";
     std::cout << "║  3. Load Position (FEN)              ║\n";
     std::cout << "║  4. Settings                         ║\n";
-    std::cout << "║  5. Exit                             ║\n";
+    std::cout << "║  5. Analyze Position                 ║\n";
+    std::cout << "║  6. Exit                             ║\n";
     std::cout << "║                                      ║\n";
     std::cout << "╚══════════════════════════════════════╝\n";
-    std::cout << "\nEnter your choice (1-5): ";
+    std::cout << "\nEnter your choice (1-6): ";
 }
 
 int ChessUI::getMenuChoice() {
     int choice;
-    while (!(std::cin >> choice) || choice < 1 || choice > 5) {
-        std::cout << "Invalid choice! Please enter 1-5: ";
+    while (!(std::cin >> choice) || choice < 1 || choice > 6) {
+        std::cout << "Invalid choice! Please enter 1-6: ";
         std::cin.clear();
         std::cin.ignore(10000, '\n');
     }
@@ -219,3 +221,19 @@ void ChessUI::displayBotStats(int nodes, int ttHits, int evaluation) {
     std::cout << "│ Evaluation: " << std::setw(8) << evaluation << " │\n";
     std::cout << "└───────────────────────┘\n";
 }
+
+void ChessUI::displaySearchProgress(int depth, int score, int mateIn, uint64_t nodes, uint64_t nps,
+                                    const std::string& pv) {
+    // Formatted on the side so std::cout keeps its own flags and precision
+    std::ostringstream line;
+    line << "depth " << std::setw(2) << depth << "  ";
+    if (mateIn != 0) {
+        line << std::setw(8) << ("M" + std::to_string(mateIn));
+    } else {
+        line << std::showpos << std::fixed << std::setprecision(2) << std::setw(8) << score / 100.0
+             << std::noshowpos;
+    }
+    line << "  " << std::setw(10) << nodes << " nodes  " << std::setw(8) << nps / 1000 << " kn/s  " << pv << "\n";
+    std::cout << line.str();
+    std::cout.flush();
+}
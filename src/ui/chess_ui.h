@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -17,6 +18,8 @@ public:
     static void displayGameResult(GameResult result, PieceColor currentTurn);
     static void displayThinking();
     static void displayBotStats(int nodes, int ttHits, int evaluation);
+    static void displaySearchProgress(int depth, int score, int mateIn, uint64_t nodes, uint64_t nps,
+                                      const std::string& pv);
     
 private:
     static char getPieceSymbol(const Piece* piece);